@@ -2,10 +2,11 @@
 // Dump muon related information for a specific event
 //////////////////////////////////////
 
-#include "FWCore/Framework/interface/EDAnalyzer.h"
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
 #include "FWCore/Utilities/interface/InputTag.h"
+#include "FWCore/Utilities/interface/Exception.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
-#include "FWCore/Framework/interface/Event.h" 
+#include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
 
 #include "DataFormats/Common/interface/Handle.h"
@@ -30,25 +31,36 @@
 
 #include "DataFormats/HepMCCandidate/interface/GenParticle.h"
 #include "SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h"
-#include "SimDataFormats/PileupSummaryInfo/interface/PileupSummaryInfo.h" 
+#include "SimDataFormats/PileupSummaryInfo/interface/PileupSummaryInfo.h"
 
 #include "DataFormats/GeometryVector/interface/VectorUtil.h"
 #include "CommonTools/CandUtils/interface/AddFourMomenta.h"
 #include "DataFormats/ParticleFlowCandidate/interface/PFCandidate.h"
 
+#include "MuonPOG/Tools/src/EventList.h"
+
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <string>
+#include <vector>
 
 template<typename T> edm::Handle<T> conditionalGet(const edm::Event & ev,
 						   const edm::InputTag & inputTag,
+						   const edm::EDGetTokenT<T> & token,
 						   const std::string & collectionName)
 {
 
   edm::Handle<T> collection ;
 
-  if (inputTag.label() != "none") 
+  if (inputTag.label() != "none")
     {
-      if (!ev.getByLabel(inputTag, collection)) 
+      if (!ev.getByToken(token, collection))
 	edm::LogError("") << "[MuonEventDumper]::conditionalGet: "
 			  << collectionName << " " << inputTag.label() << " collection does not exist !!!";
     }
@@ -56,45 +68,343 @@ template<typename T> edm::Handle<T> conditionalGet(const edm::Event & ev,
   return collection;
 
 }
-  
-class MuonEventDumper : public edm::EDAnalyzer 
+
+// Dump of one event, formatted in a buffer that is written with a single
+// call at the end of the event. Fields are grouped in (nested) objects
+// and lists, items of a list have an empty key. Formats are :
+//  - TEXT   : human readable, one field per line
+//  - JSON   : one JSON object per event, one event per line
+//  - BINARY : one record per event, a stream starts with "MPOGDMP1"
+//
+// A binary record is a uint32 payload length followed by tokens : a
+// uint8 tag, a uint16 key id for all tags but KEY, and a value (double,
+// int64, uint8, or uint32 length + chars for strings). A KEY token
+// (uint16 id, uint32 length + chars) defines a key id the first time
+// the key is used, ids stay valid for the rest of the stream and id 0
+// is the empty key. Numbers are written in the native byte order
+class DumpBuffer
+{
+public:
+
+  enum Format { TEXT, JSON, BINARY };
+
+  enum Tag { KEY = 1, OBJECT, OBJECT_END, LIST, LIST_END,
+	     REAL, INTEGER, BOOL, STRING };
+
+  DumpBuffer(Format format = TEXT) : format_(format)
+  {
+    keyIds_[""] = 0;
+  }
+
+  Format format() const { return format_; };
+
+  // Stream header, written once before the first event
+  void writeHeader(std::ostream & out) const
+  {
+    if (format_ == BINARY)
+      out.write("MPOGDMP1", 8);
+  }
+
+  void beginEvent(unsigned int run, unsigned int lumi, unsigned long long event)
+  {
+    buffer_.clear();
+    levels_.clear();
+
+    if (format_ == TEXT)
+      {
+	buffer_ += "[MuonEventDumper::analyze]: Run: ";
+	appendInteger(run);
+	buffer_ += "\tLumiBlock: ";
+	appendInteger(lumi);
+	buffer_ += "\tevent: ";
+	appendInteger(event);
+	buffer_ += '\n';
+	levels_.push_back(Level(false));
+      }
+    else
+      {
+	if (format_ == BINARY)
+	  buffer_.append(sizeof(uint32_t), '\0'); // record length, set by endEvent
+	beginObject("");
+      }
+
+    addInteger("run", run);
+    addInteger("lumi", lumi);
+    addInteger("event", event);
+  }
+
+  // Write the event dump, no flush
+  void endEvent(std::ostream & out)
+  {
+    if (format_ == TEXT)
+      levels_.pop_back();
+    else
+      endObject();
+
+    if (format_ == JSON)
+      buffer_ += '\n';
+    else if (format_ == BINARY)
+      {
+	uint32_t length = buffer_.size() - sizeof(uint32_t);
+	std::memcpy(&buffer_[0], &length, sizeof(uint32_t));
+      }
+
+    out.write(buffer_.data(), buffer_.size());
+  }
+
+  void beginObject(const std::string & key = "") { open(key, false); };
+  void endObject() { close(false); };
+
+  void beginList(const std::string & key) { open(key, true); };
+  void endList() { close(true); };
+
+  void addReal(const std::string & key, double value)
+  {
+    if (format_ == BINARY)
+      {
+	appendToken(REAL, key);
+	appendRaw(value);
+	return;
+      }
+
+    appendKey(key);
+
+    if (std::isfinite(value))
+      {
+	char number[32];
+	int length = std::snprintf(number, sizeof(number), "%.7g", value);
+	buffer_.append(number, length);
+      }
+    else
+      buffer_ += format_ == JSON ? "null" : std::isnan(value) ? "nan" : "inf";
+
+    endField();
+  }
+
+  void addInteger(const std::string & key, long long value)
+  {
+    if (format_ == BINARY)
+      {
+	appendToken(INTEGER, key);
+	appendRaw(int64_t(value));
+	return;
+      }
+
+    appendKey(key);
+    appendInteger(value);
+    endField();
+  }
+
+  void addBool(const std::string & key, bool value)
+  {
+    if (format_ == BINARY)
+      {
+	appendToken(BOOL, key);
+	appendRaw(uint8_t(value));
+	return;
+      }
+
+    appendKey(key);
+    buffer_ += value ? "true" : "false";
+    endField();
+  }
+
+  void addString(const std::string & key, const std::string & value)
+  {
+    if (format_ == BINARY)
+      {
+	appendToken(STRING, key);
+	appendString(value);
+	return;
+      }
+
+    appendKey(key);
+    if (format_ == JSON)
+      appendJsonString(value);
+    else
+      buffer_ += value;
+    endField();
+  }
+
+private:
+
+  // Object or list being filled
+  class Level
+  {
+  public:
+    Level(bool list) : isList(list), empty(true) {};
+    bool isList;
+    bool empty;
+  };
+
+  void open(const std::string & key, bool list)
+  {
+    if (format_ == BINARY)
+      appendToken(list ? LIST : OBJECT, key);
+    else if (format_ == JSON)
+      {
+	if (!levels_.empty()) appendKey(key); // not for the event object
+	buffer_ += list ? '[' : '{';
+      }
+    else
+      {
+	indent();
+	buffer_ += key.empty() ? "-" : key + " :";
+	buffer_ += '\n';
+      }
+
+    levels_.push_back(Level(list));
+  }
+
+  void close(bool list)
+  {
+    levels_.pop_back();
+
+    if (format_ == BINARY)
+      appendToken(list ? LIST_END : OBJECT_END, "");
+    else if (format_ == JSON)
+      buffer_ += list ? ']' : '}';
+  }
+
+  // JSON separator and key, TEXT indentation and label
+  void appendKey(const std::string & key)
+  {
+    Level & level = levels_.back();
+
+    if (format_ == JSON)
+      {
+	if (!level.empty) buffer_ += ',';
+	if (!level.isList)
+	  {
+	    appendJsonString(key);
+	    buffer_ += ':';
+	  }
+      }
+    else
+      {
+	indent();
+	buffer_ += key.empty() ? std::string("- ") : key + " : ";
+      }
+
+    level.empty = false;
+  }
+
+  void endField()
+  {
+    if (format_ == TEXT)
+      buffer_ += '\n';
+  }
+
+  void indent()
+  {
+    buffer_.append(2 * (levels_.size() - 1), ' ');
+  }
+
+  void appendInteger(long long value)
+  {
+    char number[24];
+    int length = std::snprintf(number, sizeof(number), "%lld", value);
+    buffer_.append(number, length);
+  }
+
+  void appendJsonString(const std::string & value)
+  {
+    buffer_ += '"';
+    for (char c : value)
+      {
+	if (c == '"' || c == '\\')
+	  {
+	    buffer_ += '\\';
+	    buffer_ += c;
+	  }
+	else if (static_cast<unsigned char>(c) < 0x20)
+	  {
+	    char escape[8];
+	    std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+	    buffer_ += escape;
+	  }
+	else
+	  buffer_ += c;
+      }
+    buffer_ += '"';
+  }
+
+  template<typename T> void appendRaw(T value)
+  {
+    buffer_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void appendString(const std::string & value)
+  {
+    appendRaw(uint32_t(value.size()));
+    buffer_ += value;
+  }
+
+  void appendToken(Tag tag, const std::string & key)
+  {
+    std::map<std::string, uint16_t>::const_iterator keyIt = keyIds_.find(key);
+
+    if (keyIt == keyIds_.end())
+      {
+	uint16_t id = keyIds_.size();
+	keyIt = keyIds_.insert(std::make_pair(key, id)).first;
+	appendRaw(uint8_t(KEY));
+	appendRaw(id);
+	appendString(key);
+      }
+
+    appendRaw(uint8_t(tag));
+    appendRaw(keyIt->second);
+  }
+
+  Format format_;
+
+  std::string buffer_;
+  std::vector<Level> levels_;
+  std::map<std::string, uint16_t> keyIds_;
+
+};
+
+class MuonEventDumper : public edm::one::EDAnalyzer<>
 {
 public:
 
   MuonEventDumper(const edm::ParameterSet &);
-  
-  virtual void analyze(const edm::Event&, const edm::EventSetup&);
-  virtual void beginRun(const edm::Run&, const edm::EventSetup&);
-  virtual void beginJob();
-  virtual void endJob();
-  
+
+  virtual void analyze(const edm::Event&, const edm::EventSetup&) override;
+  virtual void beginJob() override;
+  virtual void endJob() override;
+
 private:
-  
-  void printGenInfo(const edm::Handle<std::vector<PileupSummaryInfo> > &) const ;
 
-  void printGenParticles(const edm::Handle<reco::GenParticleCollection> &) const ;
+  void printGenInfo(DumpBuffer &, const edm::Handle<std::vector<PileupSummaryInfo> > &) const ;
+
+  void printGenParticles(DumpBuffer &, const edm::Handle<reco::GenParticleCollection> &) const ;
 
-  void printHlt(const edm::Handle<edm::TriggerResults> &, 
+  void printHlt(DumpBuffer &,
+		const edm::Handle<edm::TriggerResults> &,
 		const edm::Handle<trigger::TriggerEvent> &,
 		const edm::TriggerNames &) const ;
-  
-  void printPV(const edm::Handle<std::vector<reco::Vertex> > &) const ;
-  
-  void printMuons(const edm::Handle<reco::MuonCollection> &,
+
+  void printPV(DumpBuffer &, const edm::Handle<std::vector<reco::Vertex> > &) const ;
+
+  void printMuons(DumpBuffer &,
+		  const edm::Handle<reco::MuonCollection> &,
 		  const edm::Handle<std::vector<reco::Vertex> > &,
 		  const edm::Handle<reco::BeamSpot> &) const ;
 
-  void printTrack(const reco::Track * track,
+  void printTrack(DumpBuffer &,
+		  const reco::Track * track,
 		  const std::string & trackType) const;
 
 		  // CB copy of PF muon selections as they are in 740
   bool isIsolatedMuon(const reco::Muon& muon) const ;
-  bool isGlobalTightMuon( const reco::Muon& muon ) const ; 
+  bool isGlobalTightMuon( const reco::Muon& muon ) const ;
   bool isTrackerTightMuon( const reco::Muon& muon ) const ;
 
-  void printIsolation( const reco::MuonIsolation & iso, const std::string & cone) const;
-  void printPFIsolation( const reco::MuonPFIsolation & iso, const std::string & cone) const;
-  
+  void printIsolation(DumpBuffer &, const reco::MuonIsolation & iso, const std::string & cone) const;
+  void printPFIsolation(DumpBuffer &, const reco::MuonPFIsolation & iso, const std::string & cone) const;
+
   edm::InputTag trigResultsTag_;
   edm::InputTag trigSummaryTag_;
 
@@ -105,6 +415,31 @@ private:
   edm::InputTag genTag_;
   edm::InputTag pileUpInfoTag_;
 
+  edm::EDGetTokenT<edm::TriggerResults> trigResultsToken_;
+  edm::EDGetTokenT<trigger::TriggerEvent> trigSummaryToken_;
+
+  edm::EDGetTokenT<reco::MuonCollection> muonToken_;
+  edm::EDGetTokenT<std::vector<reco::Vertex> > primaryVertexToken_;
+  edm::EDGetTokenT<reco::BeamSpot> beamSpotToken_;
+
+  edm::EDGetTokenT<reco::GenParticleCollection> genToken_;
+  edm::EDGetTokenT<std::vector<PileupSummaryInfo> > pileUpInfoToken_;
+
+  // Events to dump (all if empty)
+  std::string eventListName_;
+  muon_pog::EventList eventList_;
+
+  unsigned long long nEvents_;
+  unsigned long long nDumped_;
+
+  // Output format and destination (std::cout if no file is given)
+  std::string dumpFormat_;
+  std::string outputFile_;
+
+  DumpBuffer dump_;
+  std::ofstream outFile_;
+  std::ostream * out_;
+
 };
 
 
@@ -118,118 +453,178 @@ MuonEventDumper::MuonEventDumper( const edm::ParameterSet & cfg ) :
   beamSpotTag_(cfg.getUntrackedParameter<edm::InputTag>("BeamSpotTag", edm::InputTag("offlineBeamSpot"))),
 
   genTag_(cfg.getUntrackedParameter<edm::InputTag>("GenTag", edm::InputTag("prunedGenParticles"))),
-  pileUpInfoTag_(cfg.getUntrackedParameter<edm::InputTag>("PileUpInfoTag", edm::InputTag("pileupInfo")))
+  pileUpInfoTag_(cfg.getUntrackedParameter<edm::InputTag>("PileUpInfoTag", edm::InputTag("pileupInfo"))),
+
+  eventListName_(cfg.getUntrackedParameter<std::string>("EventList", "")),
+  nEvents_(0),
+  nDumped_(0),
+
+  // Output
+  dumpFormat_(cfg.getUntrackedParameter<std::string>("DumpFormat", "TEXT")),
+  outputFile_(cfg.getUntrackedParameter<std::string>("OutputFile", "")),
+  out_(&std::cout)
 {
 
-}
+  // Collections labelled "none" are not read
+  if (trigResultsTag_.label() != "none")   trigResultsToken_   = consumes<edm::TriggerResults>(trigResultsTag_);
+  if (trigSummaryTag_.label() != "none")   trigSummaryToken_   = consumes<trigger::TriggerEvent>(trigSummaryTag_);
 
+  if (muonTag_.label() != "none")          muonToken_          = consumes<reco::MuonCollection>(muonTag_);
+  if (primaryVertexTag_.label() != "none") primaryVertexToken_ = consumes<std::vector<reco::Vertex> >(primaryVertexTag_);
+  if (beamSpotTag_.label() != "none")      beamSpotToken_      = consumes<reco::BeamSpot>(beamSpotTag_);
 
-void MuonEventDumper::beginJob() 
-{  
+  if (genTag_.label() != "none")           genToken_           = consumes<reco::GenParticleCollection>(genTag_);
+  if (pileUpInfoTag_.label() != "none")    pileUpInfoToken_    = consumes<std::vector<PileupSummaryInfo> >(pileUpInfoTag_);
+
+  if      (dumpFormat_ == "TEXT")   dump_ = DumpBuffer(DumpBuffer::TEXT);
+  else if (dumpFormat_ == "JSON")   dump_ = DumpBuffer(DumpBuffer::JSON);
+  else if (dumpFormat_ == "BINARY") dump_ = DumpBuffer(DumpBuffer::BINARY);
+  else
+    throw cms::Exception("Configuration") << "[MuonEventDumper]: Invalid DumpFormat : "
+					  << dumpFormat_ << " (TEXT, JSON, BINARY)";
 
 }
 
 
-void MuonEventDumper::beginRun(const edm::Run & run, const edm::EventSetup & config )
+void MuonEventDumper::beginJob()
 {
-  
+
+  if (!eventListName_.empty())
+    {
+      std::string error;
+      if (!eventList_.tryRead(eventListName_, error))
+	throw cms::Exception("Configuration") << "[MuonEventDumper]: Invalid EventList : " << error;
+      std::cout << "[MuonEventDumper]: Dumping " << eventList_.size()
+		<< " events from the event list" << std::endl;
+    }
+
+  if (!outputFile_.empty())
+    {
+      outFile_.open(outputFile_.c_str(), std::ios::out | std::ios::binary);
+      if (!outFile_)
+	throw cms::Exception("Configuration") << "[MuonEventDumper]: Can't open OutputFile : "
+					      << outputFile_;
+      out_ = &outFile_;
+    }
+
+  dump_.writeHeader(*out_);
+
 }
 
 
-void MuonEventDumper::endJob() 
+void MuonEventDumper::endJob()
 {
 
+  out_->flush();
+
+  std::cout << "[MuonEventDumper]: Dumped " << nDumped_ << " out of "
+	    << nEvents_ << " events" << std::endl;
+
+  if (outFile_.is_open())
+    outFile_.close();
+
 }
 
 void MuonEventDumper::analyze (const edm::Event & ev, const edm::EventSetup &)
 {
 
-  std::cout << "[MuonEventDumper::analyze]: "
-	    << "\nProcessing Run: " << ev.id().run()
-	    << "\tLumiBlock: " << ev.id().luminosityBlock()
-	    << "\tevent: " << ev.id().event() << std::endl;
+  ++nEvents_;
+
+  // Non listed events cost one hash lookup, no collection is read
+  if (!eventList_.empty() &&
+      !eventList_.contains(ev.id().run(), ev.id().luminosityBlock(), ev.id().event()))
+    return;
+
+  ++nDumped_;
+
+  dump_.beginEvent(ev.id().run(), ev.id().luminosityBlock(), ev.id().event());
 
   // Print GEN pile up information
-  if (!ev.isRealData()) 
+  if (!ev.isRealData())
     {
-      auto puInfo = conditionalGet<std::vector<PileupSummaryInfo> >(ev,pileUpInfoTag_,"Pile-Up Info");
-      if (puInfo.isValid()) printGenInfo(puInfo);
+      auto puInfo = conditionalGet(ev,pileUpInfoTag_,pileUpInfoToken_,"Pile-Up Info");
+      if (puInfo.isValid()) printGenInfo(dump_, puInfo);
     }
-  
+
 
   // Print GEN particles information
-  if (!ev.isRealData()) 
+  if (!ev.isRealData())
     {
-      auto genParticles= conditionalGet<reco::GenParticleCollection>(ev,genTag_,"GenParticle Collection");
-      if (genParticles.isValid()) printGenParticles(genParticles);
-    } 
-  
+      auto genParticles= conditionalGet(ev,genTag_,genToken_,"GenParticle Collection");
+      if (genParticles.isValid()) printGenParticles(dump_, genParticles);
+    }
+
   // Print trigger information
-  auto triggerResults = conditionalGet<edm::TriggerResults>(ev,trigResultsTag_,"TriggerResults");
-  auto triggerEvent   = conditionalGet<trigger::TriggerEvent>(ev,trigSummaryTag_,"TriggerEvent");
-      
-  if (triggerResults.isValid() && triggerEvent.isValid()) 
-    printHlt(triggerResults, triggerEvent,ev.triggerNames(*triggerResults));
-  
+  auto triggerResults = conditionalGet(ev,trigResultsTag_,trigResultsToken_,"TriggerResults");
+  auto triggerEvent   = conditionalGet(ev,trigSummaryTag_,trigSummaryToken_,"TriggerEvent");
+
+  if (triggerResults.isValid() && triggerEvent.isValid())
+    printHlt(dump_, triggerResults, triggerEvent,ev.triggerNames(*triggerResults));
+
   // Print vertex information
-  auto vertexes = conditionalGet<std::vector<reco::Vertex> >(ev,primaryVertexTag_,"Vertex");
-  if (vertexes.isValid()) printPV(vertexes);
-  
+  auto vertexes = conditionalGet(ev,primaryVertexTag_,primaryVertexToken_,"Vertex");
+  if (vertexes.isValid()) printPV(dump_, vertexes);
+
   // Get beam spot for muons
-  auto beamSpot = conditionalGet<reco::BeamSpot>(ev,beamSpotTag_,"BeamSpot");
+  auto beamSpot = conditionalGet(ev,beamSpotTag_,beamSpotToken_,"BeamSpot");
 
-  // Get muons  
-  auto muons = conditionalGet<reco::MuonCollection>(ev,muonTag_,"MuonCollection");
+  // Get muons
+  auto muons = conditionalGet(ev,muonTag_,muonToken_,"MuonCollection");
 
   // Print muon information
-  if (muons.isValid() && vertexes.isValid() && beamSpot.isValid()) 
-    printMuons(muons,vertexes,beamSpot);
-  
+  if (muons.isValid() && vertexes.isValid() && beamSpot.isValid())
+    printMuons(dump_, muons,vertexes,beamSpot);
+
+  // One write per event
+  dump_.endEvent(*out_);
+
 }
 
 
-void MuonEventDumper::printGenInfo(const edm::Handle<std::vector<PileupSummaryInfo> > & puInfo) const
+void MuonEventDumper::printGenInfo(DumpBuffer & dump,
+				   const edm::Handle<std::vector<PileupSummaryInfo> > & puInfo) const
 {
 
   // muon_hlt::GenInfo genInfo;
-  
+
   // genInfo.trueNumberOfInteractions   = -1.;
-  // genInfo.actualNumberOfInteractions = -1 ;    
-  
+  // genInfo.actualNumberOfInteractions = -1 ;
+
   // std::vector<PileupSummaryInfo>::const_iterator puInfoIt  = puInfo->begin();
   // std::vector<PileupSummaryInfo>::const_iterator puInfoEnd = puInfo->end();
 
-  // for(; puInfoIt != puInfoEnd; ++puInfoIt) 
+  // for(; puInfoIt != puInfoEnd; ++puInfoIt)
   //   {
-    
+
   //     int bx = puInfoIt->getBunchCrossing();
-	  
-  //     if(bx == 0) 
-  // 	{ 
+
+  //     if(bx == 0)
+  // 	{
   // 	  genInfo.trueNumberOfInteractions   = puInfoIt->getTrueNumInteractions();
   // 	  genInfo.actualNumberOfInteractions = puInfoIt->getPU_NumInteractions();
   // 	  continue;
   // 	}
   //   }
-  
+
   // event_.genInfos.push_back(genInfo);
 
   return; // to be implementded
-  
+
 }
 
 
-void MuonEventDumper::printGenParticles(const edm::Handle<reco::GenParticleCollection> & genParticles) const
+void MuonEventDumper::printGenParticles(DumpBuffer & dump,
+					const edm::Handle<reco::GenParticleCollection> & genParticles) const
 {
-  
+
   // unsigned int gensize = genParticles->size();
-  
+
   // // Do not record the initial protons
-  // for (unsigned int i=0; i<gensize; ++i) 
+  // for (unsigned int i=0; i<gensize; ++i)
   //   {
 
   //     const reco::GenParticle& part = genParticles->at(i);
-    
+
   //     muon_hlt::GenParticle gensel;
   //     gensel.pdgId = part.pdgId();
   //     gensel.status = part.status();
@@ -244,14 +639,14 @@ void MuonEventDumper::printGenParticles(const edm::Handle<reco::GenParticleColle
   //     gensel.mothers.clear();
   //     unsigned int nMothers = part.numberOfMothers();
 
-  //     for (unsigned int iMother=0; iMother<nMothers; ++iMother) 
+  //     for (unsigned int iMother=0; iMother<nMothers; ++iMother)
   // 	{
   // 	  gensel.mothers.push_back(part.motherRef(iMother)->pdgId());
   // 	}
 
   //     // Protect agains bug in genParticles (missing mother => first proton)
   //     if (i>=2 && nMothers==0) gensel.mothers.push_back(0);
-      
+
   //     event_.genParticles.push_back(gensel);
   //   }
 
@@ -259,70 +654,72 @@ void MuonEventDumper::printGenParticles(const edm::Handle<reco::GenParticleColle
 }
 
 
-void MuonEventDumper::printHlt(const edm::Handle<edm::TriggerResults> & triggerResults, 
-				  const edm::Handle<trigger::TriggerEvent> & triggerEvent,
+void MuonEventDumper::printHlt(DumpBuffer & dump,
+			       const edm::Handle<edm::TriggerResults> & triggerResults,
+			       const edm::Handle<trigger::TriggerEvent> & triggerEvent,
 			       const edm::TriggerNames & triggerNames) const
-{    
+{
+
+  dump.beginObject("hlt");
 
-  std::cout << "[MuonEventDumper::printHlt]: "
-	    << "\nPatsh from trigger results : " << std::endl;
+  // Paths from trigger results
+  dump.beginList("paths");
 
-    for (unsigned int iTrig=0; iTrig<triggerNames.size(); ++iTrig) 
+  for (unsigned int iTrig=0; iTrig<triggerNames.size(); ++iTrig)
     {
-      
-      if (triggerResults->accept(iTrig)) 
-	{
-	  std::string pathName = triggerNames.triggerName(iTrig);
- 	  std::cout << "[PATH]: " << pathName << std::endl; 
-	}
+
+      if (triggerResults->accept(iTrig))
+	dump.addString("", triggerNames.triggerName(iTrig));
     }
-      
-  std::cout << "[MuonEventDumper::printHlt]: "
-	    << "\nTrigger Objects : " << std::endl;
 
-    const trigger::size_type nFilters(triggerEvent->sizeFilters());
+  dump.endList();
 
-  for (trigger::size_type iFilter=0; iFilter!=nFilters; ++iFilter) 
+  // Trigger objects
+  dump.beginList("objects");
+
+  const trigger::size_type nFilters(triggerEvent->sizeFilters());
+  const trigger::TriggerObjectCollection& triggerObjects(triggerEvent->getObjects());
+
+  for (trigger::size_type iFilter=0; iFilter!=nFilters; ++iFilter)
     {
-	
+
       std::string filterTag = triggerEvent->filterTag(iFilter).encode();
 
-      trigger::Keys objectKeys = triggerEvent->filterKeys(iFilter);
-      const trigger::TriggerObjectCollection& triggerObjects(triggerEvent->getObjects());
-	
-      for (trigger::size_type iKey=0; iKey<objectKeys.size(); ++iKey) 
-	{  
+      const trigger::Keys & objectKeys = triggerEvent->filterKeys(iFilter);
+
+      for (trigger::size_type iKey=0; iKey<objectKeys.size(); ++iKey)
+	{
 	  trigger::size_type objKey = objectKeys.at(iKey);
 	  const trigger::TriggerObject& triggerObj(triggerObjects[objKey]);
-	  
-	  float trigObjPt = triggerObj.pt();
-	  float trigObjEta = triggerObj.eta();
-	  float trigObjPhi = triggerObj.phi();	  
-	  
- 	  std::cout << "[OBJECT]: (pt, eta, phi) ("
-		    << trigObjPt << ", "
-		    << trigObjEta << ", "
-		    << trigObjPhi << ") "
-		    <<filterTag << std::endl; 
-
-	}       
+
+	  dump.beginObject();
+	  dump.addReal("pt",  triggerObj.pt());
+	  dump.addReal("eta", triggerObj.eta());
+	  dump.addReal("phi", triggerObj.phi());
+	  dump.addString("filter", filterTag);
+	  dump.endObject();
+	}
     }
 
+  dump.endList();
+
+  dump.endObject();
+
 }
 
 
-void MuonEventDumper::printPV(const edm::Handle<std::vector<reco::Vertex> > & vertexes) const
+void MuonEventDumper::printPV(DumpBuffer & dump,
+			      const edm::Handle<std::vector<reco::Vertex> > & vertexes) const
 {
-      
-  std::cout << "[MuonEventDumper::printPV]: "
-	    << "\nFirst Vertex : " << std::endl;
 
-    int nVtx = 0;
+  dump.beginObject("vertices");
+
+  int nVtx = 0;
 
   std::vector<reco::Vertex>::const_iterator vertexIt  = vertexes->begin();
   std::vector<reco::Vertex>::const_iterator vertexEnd = vertexes->end();
 
-  for (; vertexIt != vertexEnd; ++vertexIt) 
+  for (; vertexIt != vertexEnd; ++vertexIt)
     {
 
       const reco::Vertex& vertex = *vertexIt;
@@ -330,193 +727,194 @@ void MuonEventDumper::printPV(const edm::Handle<std::vector<reco::Vertex> > & ve
       if (!vertex.isValid()) continue;
       ++nVtx;
 
-      if (vertexIt == vertexes->begin()) 
+      if (vertexIt == vertexes->begin())
 	{
-	  std::cout << "Coordinates (x, y, z) : ("
-		    << vertex.x() << ", "
-		    << vertex.y() << ", "
-		    << vertex.z() << " )"
-		    <<  std::endl;
+	  dump.beginObject("first");
+	  dump.addReal("x", vertex.x());
+	  dump.addReal("y", vertex.y());
+	  dump.addReal("z", vertex.z());
+	  dump.endObject();
 	}
     }
-  
-  std::cout << "Number of vertices : " << nVtx << std::endl;
-  
+
+  dump.addInteger("nVertices", nVtx);
+
+  dump.endObject();
+
 }
 
-void MuonEventDumper::printTrack(const reco::Track * track, const std::string & trackType) const
+void MuonEventDumper::printTrack(DumpBuffer & dump,
+				 const reco::Track * track, const std::string & trackType) const
 {
-  
-  std::cout << "[From " << trackType << "] : pT :" << track->pt()
-	    << " , sigma(pT)/pT :" << track->ptError()/track->pt()
-	    << " , eta :" << track->eta()
-	    << " , phi :" << track->phi()
-	    << " , charge :" << track->charge()
-	    << " , n.d.o.f. :" << track->ndof()
-	    << " , chi2/n.d.o.f. :" << track->normalizedChi2()
-	    << " , # pixel hits :" << track->hitPattern().numberOfValidPixelHits()
-	    << " , # trk layers :" << track->hitPattern().trackerLayersWithMeasurement()
-	    << " , # muon hits :" << track->hitPattern().numberOfValidMuonHits()
-	    << " , # muon valid hits :" << track->hitPattern().numberOfMuonHits()
-	    << " , # DT valid hits :" << track->hitPattern().numberOfValidMuonDTHits()
-	    << " , # CSC valid hits :" << track->hitPattern().numberOfValidMuonCSCHits()
-	    << " , # RPC valid hits :" << track->hitPattern().numberOfValidMuonRPCHits()
-	    << " , # DT bad hits :" << track->hitPattern().numberOfBadMuonDTHits()
-	    << " , # CSC bad hits :" << track->hitPattern().numberOfBadMuonCSCHits()
-	    << " , # RPC bad hits :" << track->hitPattern().numberOfBadMuonRPCHits()
-	    << " , # DT lost hits :" << track->hitPattern().numberOfLostMuonDTHits()
-	    << " , # CSC lost hits :" << track->hitPattern().numberOfLostMuonCSCHits()
-	    << " , # RPC lost hits :" << track->hitPattern().numberOfLostMuonRPCHits()
-	    << " , # muon stations with valid hits :" << track->hitPattern().muonStationsWithValidHits()
-	    << " , # DT stations with valid hits :" << track->hitPattern().dtStationsWithValidHits()
-	    << " , # CSC stations with valid hits :" << track->hitPattern().cscStationsWithValidHits()
-	    << " , # RPC stations with valid hits :" << track->hitPattern().rpcStationsWithValidHits()
-	    << " , # muon stations with valid hits :" << track->hitPattern().muonStationsWithValidHits()
-	    << " , # DT stations with any hits :" << track->hitPattern().dtStationsWithAnyHits()
-	    << " , # CSC stations with any hits :" << track->hitPattern().cscStationsWithAnyHits()
-	    << " , # RPC stations with any hits :" << track->hitPattern().rpcStationsWithAnyHits()
-	    << std::endl;  
-  
+
+  const reco::HitPattern & hitPattern = track->hitPattern();
+
+  dump.beginObject();
+
+  dump.addString("type", trackType);
+  dump.addReal("pt", track->pt());
+  dump.addReal("ptRelError", track->ptError()/track->pt());
+  dump.addReal("eta", track->eta());
+  dump.addReal("phi", track->phi());
+  dump.addInteger("charge", track->charge());
+  dump.addReal("ndof", track->ndof());
+  dump.addReal("normChi2", track->normalizedChi2());
+
+  dump.addInteger("pixelHits", hitPattern.numberOfValidPixelHits());
+  dump.addInteger("trackerLayers", hitPattern.trackerLayersWithMeasurement());
+  dump.addInteger("muonValidHits", hitPattern.numberOfValidMuonHits());
+  dump.addInteger("muonHits", hitPattern.numberOfMuonHits());
+  dump.addInteger("dtValidHits", hitPattern.numberOfValidMuonDTHits());
+  dump.addInteger("cscValidHits", hitPattern.numberOfValidMuonCSCHits());
+  dump.addInteger("rpcValidHits", hitPattern.numberOfValidMuonRPCHits());
+  dump.addInteger("dtBadHits", hitPattern.numberOfBadMuonDTHits());
+  dump.addInteger("cscBadHits", hitPattern.numberOfBadMuonCSCHits());
+  dump.addInteger("rpcBadHits", hitPattern.numberOfBadMuonRPCHits());
+  dump.addInteger("dtLostHits", hitPattern.numberOfLostMuonDTHits());
+  dump.addInteger("cscLostHits", hitPattern.numberOfLostMuonCSCHits());
+  dump.addInteger("rpcLostHits", hitPattern.numberOfLostMuonRPCHits());
+  dump.addInteger("muonStationsWithValidHits", hitPattern.muonStationsWithValidHits());
+  dump.addInteger("dtStationsWithValidHits", hitPattern.dtStationsWithValidHits());
+  dump.addInteger("cscStationsWithValidHits", hitPattern.cscStationsWithValidHits());
+  dump.addInteger("rpcStationsWithValidHits", hitPattern.rpcStationsWithValidHits());
+  dump.addInteger("dtStationsWithAnyHits", hitPattern.dtStationsWithAnyHits());
+  dump.addInteger("cscStationsWithAnyHits", hitPattern.cscStationsWithAnyHits());
+  dump.addInteger("rpcStationsWithAnyHits", hitPattern.rpcStationsWithAnyHits());
+
+  dump.endObject();
+
 }
 
-void MuonEventDumper::printMuons(const edm::Handle<reco::MuonCollection> & muons,
-				    const edm::Handle<std::vector<reco::Vertex> > & vertexes,
-				    const edm::Handle<reco::BeamSpot> & beamSpot) const
+void MuonEventDumper::printMuons(DumpBuffer & dump,
+				 const edm::Handle<reco::MuonCollection> & muons,
+				 const edm::Handle<std::vector<reco::Vertex> > & vertexes,
+				 const edm::Handle<reco::BeamSpot> & beamSpot) const
 {
 
-  std::cout << "[MuonEventDumper::printMuons]: " << std::endl;
-
+  dump.beginList("muons");
 
   reco::MuonCollection::const_iterator muonIt  = muons->begin();
   reco::MuonCollection::const_iterator muonEnd = muons->end();
 
-  for (; muonIt != muonEnd; ++muonIt) 
+  for (; muonIt != muonEnd; ++muonIt)
     {
 
       const reco::Muon& mu = (*muonIt);
-      const reco::Vertex & vertex = vertexes->at(0); // CB for now vertex is always valid, but add a protection	    
+      const reco::Vertex & vertex = vertexes->at(0); // CB for now vertex is always valid, but add a protection
 
-      std::cout << "[MUON DETAILS]: " << std::endl;
-      
-      std::cout << "It is a : "
-		<< (mu.isStandAloneMuon() ? "STANDALONE " : "")
-		<< (mu.isGlobalMuon() ? "GLOBAL " : "")
-		<< (mu.isTrackerMuon() ? "TRACKER " : "")
-		<< (mu.isPFMuon() ? "PF " : "")
-		<< "muon." << std::endl;
-
-      std::cout << "With eta : " << mu.eta()
-		<< " , phi : " << mu.phi()
-		<< " , charge : " << mu.charge()
-		<< std::endl ;
+      dump.beginObject();
+
+      dump.addBool("isStandAlone", mu.isStandAloneMuon());
+      dump.addBool("isGlobal", mu.isGlobalMuon());
+      dump.addBool("isTracker", mu.isTrackerMuon());
+      dump.addBool("isPF", mu.isPFMuon());
+
+      dump.addReal("eta", mu.eta());
+      dump.addReal("phi", mu.phi());
+      dump.addInteger("charge", mu.charge());
 
       if (mu.isGlobalMuon())
-	std::cout << "With (dYX, dZ) for global track : ("
-		  << mu.globalTrack()->dxy() << ", "
-		  << mu.globalTrack()->dz() << ")"
-		  << std::endl;
-      
-      if (!mu.innerTrack().isNull())
-	std::cout << "With (dYX, dZ) for inner track : ("
-		  << mu.innerTrack()->dxy() << ", "
-		  << mu.innerTrack()->dz() << ")"
-		  << std::endl;
+	{
+	  dump.addReal("globalDxy", mu.globalTrack()->dxy());
+	  dump.addReal("globalDz", mu.globalTrack()->dz());
+	}
 
-      std::cout << "PF id variables: "
-		<< "GLOBAL_TIGHT : "  << (isGlobalTightMuon(mu)  ? "TRUE  " : "FALSE  ")
-		<< "TRACKER_TIGHT : " << (isTrackerTightMuon(mu) ? "TRUE  " : "FALSE  ")
-		<< "ISOLATED : "      << (isIsolatedMuon(mu)     ? "TRUE  " : "FALSE  ")
-		<< std::endl;
+      if (!mu.innerTrack().isNull())
+	{
+	  dump.addReal("innerDxy", mu.innerTrack()->dxy());
+	  dump.addReal("innerDz", mu.innerTrack()->dz());
+	}
 
+      // PF id variables
+      dump.addBool("isPFGlobalTight", isGlobalTightMuon(mu));
+      dump.addBool("isPFTrackerTight", isTrackerTightMuon(mu));
+      dump.addBool("isPFIsolated", isIsolatedMuon(mu));
 
-      std::cout << "With track parameters : \n";
+      dump.beginList("tracks");
 
       if (mu.isGlobalMuon())
-	printTrack(mu.tunePMuonBestTrack().get(),"TUNEP");
-      
+	printTrack(dump,mu.tunePMuonBestTrack().get(),"TUNEP");
+
       if (mu.isPFMuon())
-	printTrack(mu.muonBestTrack().get(),"PF");
+	printTrack(dump,mu.muonBestTrack().get(),"PF");
 
       if (!mu.innerTrack().isNull())
-	printTrack(mu.innerTrack().get(),"INNER");
+	printTrack(dump,mu.innerTrack().get(),"INNER");
 
       if (!mu.globalTrack().isNull())
-	printTrack(mu.globalTrack().get(),"GLB");
+	printTrack(dump,mu.globalTrack().get(),"GLB");
 
       if (!mu.pickyTrack().isNull())
-	printTrack(mu.pickyTrack().get(),"PICKY");
+	printTrack(dump,mu.pickyTrack().get(),"PICKY");
 
       if (!mu.tpfmsTrack().isNull())
-	printTrack(mu.tpfmsTrack().get(),"TPFMS");
+	printTrack(dump,mu.tpfmsTrack().get(),"TPFMS");
 
       if (!mu.dytTrack().isNull())
-	printTrack(mu.dytTrack().get(),"DYT");
-      
+	printTrack(dump,mu.dytTrack().get(),"DYT");
+
       if (!mu.outerTrack().isNull())
-	printTrack(mu.outerTrack().get(),"STANDALONE");
-     
+	printTrack(dump,mu.outerTrack().get(),"STANDALONE");
+
+      dump.endList();
+
       if (mu.isTimeValid())
 	{
 	  const reco::MuonTime time = mu.time();
-	    std::cout << "[Muon TIME] : n.d.o.f. :" << time.nDof
-		      << " , time at IP IN->OUT :" << time.timeAtIpInOut
-		      << " , error on time at IP IN->OUT :" << time.timeAtIpInOutErr
-		      << std::endl;
+	  dump.beginObject("time");
+	  dump.addInteger("ndof", time.nDof);
+	  dump.addReal("timeAtIpInOut", time.timeAtIpInOut);
+	  dump.addReal("timeAtIpInOutErr", time.timeAtIpInOutErr);
+	  dump.endObject();
 	}
-      
-      std::cout << "It passes the : "
-		<< (muon::isSoftMuon(mu,vertex)     ? "SOFT " : "")
-		<< (muon::isLooseMuon(mu)           ? "LOOSE " : "")
-		<< (muon::isTightMuon(mu,vertex)    ? "TIGHT " : "")
-		<< (muon::isHighPtMuon(mu,vertex) ? "HIGH_PT " : "")
-		<< " IDs." << std::endl;      
+
+      dump.addBool("isSoft", muon::isSoftMuon(mu,vertex));
+      dump.addBool("isLoose", muon::isLooseMuon(mu));
+      dump.addBool("isTight", muon::isTightMuon(mu,vertex));
+      dump.addBool("isHighPt", muon::isHighPtMuon(mu,vertex));
 
       reco::MuonIsolation iso03 = mu.isolationR03();
-      printIsolation(iso03,"0.3");
-      
-      reco::MuonPFIsolation isoPF03 = mu.pfIsolationR04();
+      printIsolation(dump,iso03,"03");
+
+      reco::MuonPFIsolation isoPF03 = mu.pfIsolationR03();
       reco::MuonPFIsolation isoPF04 = mu.pfIsolationR04();
 
-      printPFIsolation(isoPF03,"0.3");
-      printPFIsolation(isoPF04,"0.4");
+      printPFIsolation(dump,isoPF03,"03");
+      printPFIsolation(dump,isoPF04,"04");
+
+      dump.endObject();
 
     }
 
+  dump.endList();
+
 }
 
-void MuonEventDumper::printIsolation( const reco::MuonIsolation & iso, const std::string & cone) const
+void MuonEventDumper::printIsolation(DumpBuffer & dump,
+				     const reco::MuonIsolation & iso, const std::string & cone) const
 {
 
-  double sumPt   = iso.sumPt;
-  double emEt    = iso.emEt;
-  double hadEt   = iso.hadEt;
-  int nTracks = iso.nTracks;
-  int nJets   = iso.nJets;
-
-  std::cout << "Detector Based Isolation variables are (R=" << cone << ") : "
-	    << "\nsumPt: " << sumPt 
-	    << "\nemEt : " << emEt
-	    << "\nhadEt : " << hadEt
-	    << "\nnTracks : " << nTracks
-	    << "\nnJets: " << nJets
-	    << std::endl;
+  // Detector based isolation
+  dump.beginObject("isoR" + cone);
+  dump.addReal("sumPt", iso.sumPt);
+  dump.addReal("emEt", iso.emEt);
+  dump.addReal("hadEt", iso.hadEt);
+  dump.addInteger("nTracks", iso.nTracks);
+  dump.addInteger("nJets", iso.nJets);
+  dump.endObject();
 
 }
 
-void MuonEventDumper::printPFIsolation( const reco::MuonPFIsolation & iso, const std::string & cone) const
+void MuonEventDumper::printPFIsolation(DumpBuffer & dump,
+				       const reco::MuonPFIsolation & iso, const std::string & cone) const
 {
 
-  double chargedHadronIso = iso.sumChargedHadronPt;
-  double neutralHadronIso = iso.sumNeutralHadronEt;
-  double photonIso        = iso.sumPhotonEt;
-  double pu               = iso.sumPUPt;
-      
-  std::cout << "PF Isolation variables are (R=" << cone << ") : "
-	    << "\nCh. Had (from vtx) : " << chargedHadronIso
-	    << "\nNeu. Had : " << neutralHadronIso
-	    << "\nPhot. : " << photonIso
-	    << "\nPU. : " << pu
-	    << std::endl;
+  dump.beginObject("pfIsoR" + cone);
+  dump.addReal("chargedHadron", iso.sumChargedHadronPt);
+  dump.addReal("neutralHadron", iso.sumNeutralHadronEt);
+  dump.addReal("photon", iso.sumPhotonEt);
+  dump.addReal("pu", iso.sumPUPt);
+  dump.endObject();
 
 }
 
@@ -2,8 +2,9 @@
 // Ntuplizer that fills muon_pog trees
 //////////////////////////////////////
 
-#include "FWCore/Framework/interface/EDAnalyzer.h"
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
 #include "FWCore/Utilities/interface/InputTag.h"
+#include "FWCore/Utilities/interface/Exception.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/Framework/interface/Event.h" 
 #include "FWCore/Framework/interface/EventSetup.h"
@@ -35,33 +36,80 @@
 #include "FWCore/Common/interface/TriggerNames.h"
 #include "DataFormats/Common/interface/TriggerResults.h"
 #include "DataFormats/HLTReco/interface/TriggerEvent.h"
+#include "HLTrigger/HLTcore/interface/HLTConfigProvider.h"
 
 #include "DataFormats/HepMCCandidate/interface/GenParticle.h"
 #include "SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h"
 #include "SimDataFormats/PileupSummaryInfo/interface/PileupSummaryInfo.h" 
 
 #include "DataFormats/GeometryVector/interface/VectorUtil.h"
+#include "DataFormats/Math/interface/deltaR.h"
 #include "CommonTools/CandUtils/interface/AddFourMomenta.h"
 #include "DataFormats/ParticleFlowCandidate/interface/PFCandidate.h"
 
 #include "MuonPOG/Tools/src/MuonPogTree.h"
+#include "MuonPOG/Tools/src/MuonPogColumns.h"
 #include "TTree.h"
+#include "TBranch.h"
+#include "TObjArray.h"
+#include "TH1D.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <unordered_map>
 
-class MuonPogTreeProducer : public edm::EDAnalyzer 
+// Instrumentation of one fill stage : number of calls, wall time
+// and number of calls in which the ntuple containers had to grow
+// (i.e. allocated memory)
+class FillStage 
+{
+public:
+
+  FillStage(const std::string & name) :
+    name_(name), nCalls_(0), nAllocs_(0), time_(0.) { };
+
+  const std::string & name() const { return name_; };
+  unsigned long nCalls()  const { return nCalls_; };
+  unsigned long nAllocs() const { return nAllocs_; };
+  double time() const { return time_; }; // [s]
+
+  void add(double time, bool hasAllocated) 
+  {
+    ++nCalls_;
+    time_ += time;
+    if (hasAllocated) ++nAllocs_;
+  };
+
+private:
+
+  std::string name_;
+  unsigned long nCalls_;
+  unsigned long nAllocs_;
+  double time_;
+
+};
+
+// one::EDAnalyzer sharing the TFileService resource : cmsRun can run
+// it in multithreaded jobs, serialised only with the other modules
+// using TFileService, while every other module runs concurrently
+class MuonPogTreeProducer : public edm::one::EDAnalyzer<edm::one::SharedResources, edm::one::WatchRuns> 
 {
 public:
 
   MuonPogTreeProducer(const edm::ParameterSet &);
   
-  virtual void analyze(const edm::Event&, const edm::EventSetup&);
-  virtual void beginRun(const edm::Run&, const edm::EventSetup&);
-  virtual void beginJob();
-  virtual void endJob();
+  virtual void analyze(const edm::Event&, const edm::EventSetup&) override;
+  virtual void beginRun(const edm::Run&, const edm::EventSetup&) override;
+  virtual void endRun(const edm::Run&, const edm::EventSetup&) override;
+  virtual void beginJob() override;
+  virtual void endJob() override;
   
 private:
+
+  bool passSkim(const edm::Event &);
   
   void fillGenInfo(const edm::Handle<std::vector<PileupSummaryInfo> > &,
 		   const  edm::Handle<GenEventInfoProduct> &);
@@ -93,8 +141,86 @@ private:
   edm::InputTag pileUpInfoTag_;
   edm::InputTag genInfoTag_;
 
+  double genMatchMaxDr_; // max dR of gen <-> reco muon matches
+  std::vector<unsigned int> genMuons_; // indices of the status 1 gen muons of the event
+
+  // Tokens for the collections above, not set for collections labelled "none"
+  edm::EDGetTokenT<edm::TriggerResults> trigResultsToken_;
+  edm::EDGetTokenT<trigger::TriggerEvent> trigSummaryToken_;
+
+  edm::EDGetTokenT<reco::MuonCollection> muonToken_;
+  edm::EDGetTokenT<std::vector<reco::Vertex> > primaryVertexToken_;
+  edm::EDGetTokenT<reco::BeamSpot> beamSpotToken_;
+
+  edm::EDGetTokenT<reco::PFMETCollection> pfMetToken_;
+  edm::EDGetTokenT<reco::PFMETCollection> pfChMetToken_;
+  edm::EDGetTokenT<reco::CaloMETCollection> caloMetToken_;
+
+  edm::EDGetTokenT<reco::GenParticleCollection> genToken_;
+  edm::EDGetTokenT<std::vector<PileupSummaryInfo> > pileUpInfoToken_;
+  edm::EDGetTokenT<GenEventInfoProduct> genInfoToken_;
+
+  // Skim : only events with at least skimMinNMuons_ muons passing
+  // pt and ID cuts and firing one of skimHltPaths_ are stored
+  int skimMinNMuons_;
+  double skimMuonMinPt_;
+  enum SkimMuonId { SKIM_ID_NONE=0, SKIM_ID_GLOBAL, SKIM_ID_LOOSE, SKIM_ID_MEDIUM, SKIM_ID_TIGHT };
+  SkimMuonId skimMuonID_; // parsed once from the SkimMuonID string
+  std::vector<std::string> skimHltPaths_;
+
+  edm::ParameterSetID skimTriggerNamesID_;   // trigger menu skimPathIndices_ refer to
+  std::vector<unsigned int> skimPathIndices_; // paths matching skimHltPaths_
+
+  TH1D * skimCounters_;
+
+  // Fill stages instrumentation
+  enum FillStageId { GEN_INFO=0, GEN_PARTICLES, HLT, PV, MET, MUONS, TREE_FILL, N_FILL_STAGES };
+
+  std::size_t containersCapacity() const;
+  void startStage();
+  void stopStage(FillStageId stageId);
+
+  // Per branch sizes, printed and optionally stored at endJob, branches
+  // are named by their full path (parent/.../branch)
+  void reportBranches(edm::LogVerbatim & log, TObjArray * branches, Long64_t nEntries,
+		      const std::string & parentPath);
+
+  bool fillStats_;  // allocation counting (timing is always on)
+  bool statsTree_;  // store the summary in the MUONPOGSTATS tree
+
+  TTree * statsTreePtr_;
+  std::string statsName_;
+  std::string statsKind_;
+  Long64_t statsCount_;
+  Double_t statsTime_;
+  Long64_t statsTotBytes_;
+  Long64_t statsZipBytes_;
+
+  std::vector<FillStage> fillStages_;
+  std::chrono::steady_clock::time_point stageStart_;
+  std::size_t stageCapacity_;
+
+  // Output tree layout and compression
+  std::string compression_;
+  int compressionLevel_;
+  int basketSize_;
+  int splitLevel_;
+  long long autoFlush_;
+  int compressionSettings_; // 100 * algorithm + level, -1 keeps the file settings
+
+  bool storeMuonObjects_; // std::vector<muon_pog::Muon> in the event branch
+  bool storeMuonColumns_; // one muons_<member> branch per muon_pog::Muon member
+
+  HLTConfigProvider hltConfig_;
+  edm::ParameterSetID hltTriggerNamesID_; // trigger menu hltNamesMatch_ refers to
+  bool hltNamesMatch_;                     // menu paths are hltNames_.paths, in order
+  std::unordered_map<std::string,Int_t> hltFilterIds_; // filter tag -> index in hltNames_.filters
+
   muon_pog::Event event_;
   muon_pog::EventId eventId_;
+  muon_pog::HLTNames hltNames_;
+  muon_pog::MuonColumns muonColumns_;
+  muon_pog::Muon muonBuffer_; // filled in place when muon objects are not stored
   std::map<std::string,TTree*> tree_;
   
 };
@@ -115,10 +241,94 @@ MuonPogTreeProducer::MuonPogTreeProducer( const edm::ParameterSet & cfg ) :
 
   genTag_(cfg.getUntrackedParameter<edm::InputTag>("GenTag", edm::InputTag("prunedGenParticles"))),
   pileUpInfoTag_(cfg.getUntrackedParameter<edm::InputTag>("PileUpInfoTag", edm::InputTag("pileupInfo"))),
-  genInfoTag_(cfg.getUntrackedParameter<edm::InputTag>("GenInfoTag", edm::InputTag("generator")))
+  genInfoTag_(cfg.getUntrackedParameter<edm::InputTag>("GenInfoTag", edm::InputTag("generator"))),
+  genMatchMaxDr_(cfg.getUntrackedParameter<double>("GenMatchMaxDr", 0.2)),
+
+  // Skim
+  skimMinNMuons_(cfg.getUntrackedParameter<int>("SkimMinNMuons", 0)),
+  skimMuonMinPt_(cfg.getUntrackedParameter<double>("SkimMuonMinPt", 0.)),
+  skimMuonID_(SKIM_ID_NONE),
+  skimHltPaths_(cfg.getUntrackedParameter<std::vector<std::string> >("SkimHltPaths", std::vector<std::string>())),
+  skimCounters_(0),
+
+  // Instrumentation
+  fillStats_(cfg.getUntrackedParameter<bool>("FillStats", false)),
+  statsTree_(cfg.getUntrackedParameter<bool>("StatsTree", false)),
+  statsTreePtr_(0),
+  stageCapacity_(0),
+
+  // Output tree layout and compression
+  compression_(cfg.getUntrackedParameter<std::string>("Compression", "DEFAULT")),
+  compressionLevel_(cfg.getUntrackedParameter<int>("CompressionLevel", -1)),
+  basketSize_(cfg.getUntrackedParameter<int>("BasketSize", 64000)),
+  splitLevel_(cfg.getUntrackedParameter<int>("SplitLevel", 2)),
+  autoFlush_(cfg.getUntrackedParameter<long long>("AutoFlush", -30000000)),
+  compressionSettings_(-1),
+
+  // Muon collection layout
+  storeMuonObjects_(cfg.getUntrackedParameter<bool>("StoreMuonObjects", true)),
+  storeMuonColumns_(cfg.getUntrackedParameter<bool>("StoreMuonColumns", false)),
+
+  hltNamesMatch_(false)
   
 {
 
+  usesResource("TFileService");
+
+  fillStages_.push_back(FillStage("gen info"));
+  fillStages_.push_back(FillStage("gen particles"));
+  fillStages_.push_back(FillStage("HLT"));
+  fillStages_.push_back(FillStage("PV"));
+  fillStages_.push_back(FillStage("MET"));
+  fillStages_.push_back(FillStage("muons"));
+  fillStages_.push_back(FillStage("TTree::Fill"));
+
+  if (trigResultsTag_.label() != "none")   trigResultsToken_   = consumes<edm::TriggerResults>(trigResultsTag_);
+  if (trigSummaryTag_.label() != "none")   trigSummaryToken_   = consumes<trigger::TriggerEvent>(trigSummaryTag_);
+
+  if (muonTag_.label() != "none")          muonToken_          = consumes<reco::MuonCollection>(muonTag_);
+  if (primaryVertexTag_.label() != "none") primaryVertexToken_ = consumes<std::vector<reco::Vertex> >(primaryVertexTag_);
+  if (beamSpotTag_.label() != "none")      beamSpotToken_      = consumes<reco::BeamSpot>(beamSpotTag_);
+
+  if (pfMetTag_.label() != "none")         pfMetToken_         = consumes<reco::PFMETCollection>(pfMetTag_);
+  if (pfChMetTag_.label() != "none")       pfChMetToken_       = consumes<reco::PFMETCollection>(pfChMetTag_);
+  if (caloMetTag_.label() != "none")       caloMetToken_       = consumes<reco::CaloMETCollection>(caloMetTag_);
+
+  if (genTag_.label() != "none")           genToken_           = consumes<reco::GenParticleCollection>(genTag_);
+  if (pileUpInfoTag_.label() != "none")    pileUpInfoToken_    = consumes<std::vector<PileupSummaryInfo> >(pileUpInfoTag_);
+  if (genInfoTag_.label() != "none")       genInfoToken_       = consumes<GenEventInfoProduct>(genInfoTag_);
+
+  std::string skimMuonID = cfg.getUntrackedParameter<std::string>("SkimMuonID", "NONE");
+
+  if      (skimMuonID == "NONE")   skimMuonID_ = SKIM_ID_NONE;
+  else if (skimMuonID == "GLOBAL") skimMuonID_ = SKIM_ID_GLOBAL;
+  else if (skimMuonID == "LOOSE")  skimMuonID_ = SKIM_ID_LOOSE;
+  else if (skimMuonID == "MEDIUM") skimMuonID_ = SKIM_ID_MEDIUM;
+  else if (skimMuonID == "TIGHT")  skimMuonID_ = SKIM_ID_TIGHT;
+  else
+    throw cms::Exception("Configuration") << "[MuonPogTreeProducer]: Invalid SkimMuonID : "
+					  << skimMuonID << " (NONE, GLOBAL, LOOSE, MEDIUM, TIGHT)";
+
+  // ROOT compression settings are 100 * algorithm + level, if no level
+  // is given the ROOT default one for the algorithm is used
+  int algorithm = 0;
+  int defaultLevel = 0;
+
+  if      (compression_ == "ZLIB") { algorithm = 1; defaultLevel = 1; }
+  else if (compression_ == "LZMA") { algorithm = 2; defaultLevel = 7; }
+  else if (compression_ == "LZ4")  { algorithm = 4; defaultLevel = 4; }
+  else if (compression_ == "ZSTD") { algorithm = 5; defaultLevel = 5; }
+  else if (compression_ != "DEFAULT")
+    throw cms::Exception("Configuration") << "[MuonPogTreeProducer]: Invalid Compression : "
+					  << compression_ << " (DEFAULT, ZLIB, LZMA, LZ4, ZSTD)";
+
+  if (compressionLevel_ > 9)
+    throw cms::Exception("Configuration") << "[MuonPogTreeProducer]: Invalid CompressionLevel : "
+					  << compressionLevel_ << " (0 to 9, -1 for the algorithm default)";
+
+  if (algorithm > 0)
+    compressionSettings_ = 100 * algorithm + (compressionLevel_ >= 0 ? compressionLevel_ : defaultLevel);
+
 }
 
 
@@ -128,15 +338,96 @@ void MuonPogTreeProducer::beginJob()
   edm::Service<TFileService> fs;
   tree_["muPogTree"] = fs->make<TTree>("MUONPOGTREE","Muon POG Tree");
 
-  int splitBranches = 2;
-  tree_["muPogTree"]->Branch("event",&event_,64000,splitBranches);
-  tree_["muPogTree"]->Branch("eventId",&eventId_,64000,splitBranches);
+  // The last bin sums the sign of the generator weight of every
+  // processed MC event, to normalise skimmed samples to a luminosity
+  skimCounters_ = fs->make<TH1D>("skimCounters","Skim counters;;# events",5,0.,5.);
+  skimCounters_->GetXaxis()->SetBinLabel(1,"processed");
+  skimCounters_->GetXaxis()->SetBinLabel(2,"accepted");
+  skimCounters_->GetXaxis()->SetBinLabel(3,"rejected (muons)");
+  skimCounters_->GetXaxis()->SetBinLabel(4,"rejected (HLT)");
+  skimCounters_->GetXaxis()->SetBinLabel(5,"processed gen weights");
+
+  tree_["muPogTree"]->Branch("event",&event_,basketSize_,splitLevel_);
+  tree_["muPogTree"]->Branch("eventId",&eventId_,basketSize_,splitLevel_);
+
+  if (storeMuonColumns_)
+    {
+      muonColumns_.branch(tree_["muPogTree"]);
+      tree_["muPogTree"]->SetBasketSize("muons_*",basketSize_);
+    }
+
+  // Entries per cluster (> 0) or bytes written between flushes (< 0)
+  tree_["muPogTree"]->SetAutoFlush(autoFlush_);
+
+  // One entry per run with the HLT path and filter names
+  // referred to by the indices stored in the event
+  tree_["muPogRuns"] = fs->make<TTree>("MUONPOGRUNS","Muon POG Run Tree");
+  tree_["muPogRuns"]->Branch("hltNames",&hltNames_,64000,splitLevel_);
+
+  // Compression is set on the branches of the trees of this module
+  // only, other TFileService objects keep the file settings
+  if (compressionSettings_ >= 0)
+    {
+      for (auto & tree : tree_)
+	{
+	  TObjArray * branches = tree.second->GetListOfBranches();
+	  for (int iBranch=0; iBranch<branches->GetEntriesFast(); ++iBranch)
+	    static_cast<TBranch *>(branches->At(iBranch))->SetCompressionSettings(compressionSettings_);
+	}
+    }
 
 }
 
 
 void MuonPogTreeProducer::beginRun(const edm::Run & run, const edm::EventSetup & config )
 {
+
+  hltNames_.runNumber = run.run();
+  hltNames_.processName = trigResultsTag_.process();
+  hltNames_.paths.clear();
+  hltNames_.filters.clear();
+  hltFilterIds_.clear();
+
+  // Menu compared again to the new names at the first event
+  hltTriggerNamesID_ = edm::ParameterSetID();
+  hltNamesMatch_ = false;
+
+  if (trigResultsTag_.label() == "none" ||
+      trigSummaryTag_.label() == "none")
+    return;
+
+  bool changed = true;
+  if (!hltConfig_.init(run, config, trigResultsTag_.process(), changed))
+    {
+      edm::LogError("") << "[MuonPogTreeProducer]: HLT config for process "
+			<< trigResultsTag_.process() << " could not be initialized !!!";
+      return;
+    }
+
+  hltNames_.paths = hltConfig_.triggerNames();
+
+  for (unsigned int iPath=0; iPath<hltConfig_.size(); ++iPath)
+    {
+      for (auto & moduleLabel : hltConfig_.moduleLabels(iPath))
+	{
+	  // Same encoding as trigger::TriggerEvent::filterTag(iFilter).encode()
+	  std::string filterTag = edm::InputTag(moduleLabel, "", trigSummaryTag_.process()).encode();
+
+	  if (hltFilterIds_.find(filterTag) == hltFilterIds_.end())
+	    {
+	      hltFilterIds_[filterTag] = hltNames_.filters.size();
+	      hltNames_.filters.push_back(filterTag);
+	    }
+	}
+    }
+  
+}
+
+
+void MuonPogTreeProducer::endRun(const edm::Run & run, const edm::EventSetup & config )
+{
+
+  tree_["muPogRuns"]->Fill();
   
 }
 
@@ -144,20 +435,187 @@ void MuonPogTreeProducer::beginRun(const edm::Run & run, const edm::EventSetup &
 void MuonPogTreeProducer::endJob() 
 {
 
+  if (statsTree_)
+    {
+      edm::Service<TFileService> fs;
+      statsTreePtr_ = fs->make<TTree>("MUONPOGSTATS","Muon POG Tree producer statistics");
+      statsTreePtr_->Branch("name",&statsName_);
+      statsTreePtr_->Branch("kind",&statsKind_);         // "stage" or "branch"
+      statsTreePtr_->Branch("count",&statsCount_);       // stage calls or branch entries
+      statsTreePtr_->Branch("time",&statsTime_);         // stage wall time [s]
+      statsTreePtr_->Branch("totBytes",&statsTotBytes_); // branch uncompressed size
+      statsTreePtr_->Branch("zipBytes",&statsZipBytes_); // branch compressed size
+    }
+
+  // Wall time per fill stage
+  edm::LogVerbatim log("MuonPogTreeProducer");
+  log << "[MuonPogTreeProducer]: Fill stages summary\n";
+  log << std::setw(16) << "stage" << std::setw(12) << "calls"
+      << std::setw(16) << "time/call [us]" << std::setw(16) << "total time [s]";
+  if (fillStats_) log << std::setw(16) << "calls w/ alloc";
+  log << "\n";
+
+  for (auto & stage : fillStages_)
+    {
+      log << std::setw(16) << stage.name() << std::setw(12) << stage.nCalls()
+	  << std::setw(16) << (stage.nCalls() ? stage.time() / stage.nCalls() * 1.e6 : 0.)
+	  << std::setw(16) << stage.time();
+      if (fillStats_) log << std::setw(16) << stage.nAllocs();
+      log << "\n";
+
+      if (statsTreePtr_)
+	{
+	  statsName_ = stage.name();
+	  statsKind_ = "stage";
+	  statsCount_ = stage.nCalls();
+	  statsTime_ = stage.time();
+	  statsTotBytes_ = 0;
+	  statsZipBytes_ = 0;
+	  statsTreePtr_->Fill();
+	}
+    }
+
+  // Size per branch, baskets still in memory are written
+  // first so that compressed sizes are complete
+  TTree * tree = tree_["muPogTree"];
+  tree->FlushBaskets();
+
+  Long64_t nEntries = tree->GetEntries();
+
+  // Run/event index, saved with the tree, for random access to
+  // given events (see MuonPOG/Tools/src/EventList.h)
+  if (nEntries > 0)
+    tree->BuildIndex("eventId.runNumber","eventId.eventNumber");
+
+  log << "[MuonPogTreeProducer]: MUONPOGTREE compression : " << compression_;
+  if (compressionSettings_ >= 0)
+    log << " (settings " << compressionSettings_ << ")";
+  log << ", basket size : " << basketSize_ << ", split level : " << splitLevel_
+      << ", auto flush : " << tree->GetAutoFlush() << "\n";
+  log << "[MuonPogTreeProducer]: MUONPOGTREE total size : " << tree->GetTotBytes() << " bytes, compressed : "
+      << tree->GetZipBytes() << " bytes, ratio : "
+      << (tree->GetZipBytes() ? double(tree->GetTotBytes()) / tree->GetZipBytes() : 0.) << "\n";
+
+  log << "[MuonPogTreeProducer]: Branch sizes for " << nEntries << " events\n";
+  log << std::setw(64) << std::left << "branch" << std::right
+      << std::setw(14) << "tot [bytes]" << std::setw(14) << "zip [bytes]"
+      << std::setw(14) << "zip/event" << std::setw(10) << "ratio" << "\n";
+  
+  reportBranches(log, tree->GetListOfBranches(), nEntries, "");
+
+}
+
+
+void MuonPogTreeProducer::reportBranches(edm::LogVerbatim & log, TObjArray * branches,
+					 Long64_t nEntries, const std::string & parentPath)
+{
+
+  for (int iBranch=0; iBranch<branches->GetEntriesFast(); ++iBranch)
+    {
+      TBranch * branch = static_cast<TBranch *>(branches->At(iBranch));
+
+      // sub-branch names are not unique (e.g. runNumber in
+      // both event and eventId), the full path is
+      std::string path = parentPath.empty() ? std::string(branch->GetName()) :
+	                                      parentPath + "/" + branch->GetName();
+
+      // sizes include the sub-branches
+      Long64_t totBytes = branch->GetTotBytes("*");
+      Long64_t zipBytes = branch->GetZipBytes("*");
+
+      log << std::setw(64) << std::left << path << std::right
+	  << std::setw(14) << totBytes << std::setw(14) << zipBytes
+	  << std::setw(14) << (nEntries ? double(zipBytes) / nEntries : 0.)
+	  << std::setw(10) << (zipBytes ? double(totBytes) / zipBytes : 0.) << "\n";
+
+      if (statsTreePtr_)
+	{
+	  statsName_ = path;
+	  statsKind_ = "branch";
+	  statsCount_ = nEntries;
+	  statsTime_ = 0.;
+	  statsTotBytes_ = totBytes;
+	  statsZipBytes_ = zipBytes;
+	  statsTreePtr_->Fill();
+	}
+
+      reportBranches(log, branch->GetListOfBranches(), nEntries, path);
+    }
+
+}
+
+
+std::size_t MuonPogTreeProducer::containersCapacity() const
+{
+
+  std::size_t capacity = event_.genInfos.capacity() +
+                         event_.genParticles.capacity() +
+                         event_.muons.capacity() +
+                         event_.hlt.triggers.capacity() +
+                         event_.hlt.pathBits.capacity() +
+                         event_.hlt.objects.capacity();
+
+  for (auto & genParticle : event_.genParticles)
+    capacity += genParticle.mothers.capacity() + genParticle.motherIndices.capacity();
+  for (auto & object : event_.hlt.objects)
+    capacity += object.filterTag.capacity();
+
+  return capacity;
+
+}
+
+
+void MuonPogTreeProducer::startStage()
+{
+
+  if (fillStats_)
+    stageCapacity_ = containersCapacity();
+
+  stageStart_ = std::chrono::steady_clock::now();
+
+}
+
+
+void MuonPogTreeProducer::stopStage(FillStageId stageId)
+{
+
+  std::chrono::duration<double> time = std::chrono::steady_clock::now() - stageStart_;
+  fillStages_[stageId].add(time.count(), fillStats_ && containersCapacity() > stageCapacity_);
+
 }
 
 
 void MuonPogTreeProducer::analyze (const edm::Event & ev, const edm::EventSetup &)
 {
 
+  // Event preselection, done before any other fill
+  skimCounters_->Fill("processed",1.);
+
+  if (!ev.isRealData() && genInfoTag_.label() != "none")
+    {
+      edm::Handle<GenEventInfoProduct> genInfo;
+      if (ev.getByToken(genInfoToken_, genInfo))
+	skimCounters_->Fill("processed gen weights",
+			    genInfo->weight() > 0. ? 1. : genInfo->weight() < 0. ? -1. : 0.);
+    }
+
+  if (!passSkim(ev)) return;
+  skimCounters_->Fill("accepted",1.);
+
   // Clearing branch variables
   // and setting default values
   event_.hlt.triggers.clear();
+  event_.hlt.pathBits.clear();
   event_.hlt.objects.clear();
 
-  event_.genParticles.clear();
+  // genParticles and muons are resized in place by
+  // fillGenParticles and fillMuons, keeping their buffers
   event_.genInfos.clear();
-  event_.muons.clear();
+  muonColumns_.clear();
+  genMuons_.clear();
+
+  bool hasGenParticles = false;
+  bool hasMuons = false;
   
   event_.mets.pfMet   = -999; 
   event_.mets.pfChMet = -999; 
@@ -191,9 +649,13 @@ void MuonPogTreeProducer::analyze (const edm::Event & ev, const edm::EventSetup
 	  edm::Handle<std::vector<PileupSummaryInfo> > puInfo;
 	  edm::Handle<GenEventInfoProduct> genInfo;
 
-	  if (ev.getByLabel(pileUpInfoTag_, puInfo) &&
-	      ev.getByLabel(genInfoTag_, genInfo) ) 
-	    fillGenInfo(puInfo,genInfo);
+	  if (ev.getByToken(pileUpInfoToken_, puInfo) &&
+	      ev.getByToken(genInfoToken_, genInfo) ) 
+	    {
+	      startStage();
+	      fillGenInfo(puInfo,genInfo);
+	      stopStage(GEN_INFO);
+	    }
 	  else 
 	    edm::LogError("") << "[MuonPogTreeProducer]: Pile-Up Info collection does not exist !!!";
 	}      
@@ -206,8 +668,13 @@ void MuonPogTreeProducer::analyze (const edm::Event & ev, const edm::EventSetup
       if (genTag_.label() != "none" ) 
 	{ 
 	  edm::Handle<reco::GenParticleCollection> genParticles;
-	  if (ev.getByLabel(genTag_, genParticles)) 
-	    fillGenParticles(genParticles);
+	  if (ev.getByToken(genToken_, genParticles)) 
+	    {
+	      startStage();
+	      fillGenParticles(genParticles);
+	      stopStage(GEN_PARTICLES);
+	      hasGenParticles = true;
+	    }
 	  else 
 	    edm::LogError("") << ">>> GEN collection does not exist !!!";
 	}
@@ -222,9 +689,13 @@ void MuonPogTreeProducer::analyze (const edm::Event & ev, const edm::EventSetup
       edm::Handle<edm::TriggerResults> triggerResults;
       edm::Handle<trigger::TriggerEvent> triggerEvent;
       
-      if (ev.getByLabel(trigResultsTag_, triggerResults) &&
-	  ev.getByLabel(trigSummaryTag_, triggerEvent)) 
-	fillHlt(triggerResults, triggerEvent,ev.triggerNames(*triggerResults));
+      if (ev.getByToken(trigResultsToken_, triggerResults) &&
+	  ev.getByToken(trigSummaryToken_, triggerEvent)) 
+	{
+	  startStage();
+	  fillHlt(triggerResults, triggerEvent,ev.triggerNames(*triggerResults));
+	  stopStage(HLT);
+	}
       else 
 	edm::LogError("") << "[MuonPogTreeProducer]: Trigger collections do not exist !!!";
     }
@@ -235,8 +706,12 @@ void MuonPogTreeProducer::analyze (const edm::Event & ev, const edm::EventSetup
 
   if(primaryVertexTag_.label() != "none") 
     {
-      if (ev.getByLabel(primaryVertexTag_, vertexes))
-	fillPV(vertexes);
+      if (ev.getByToken(primaryVertexToken_, vertexes))
+	{
+	  startStage();
+	  fillPV(vertexes);
+	  stopStage(PV);
+	}
       else 
 	edm::LogError("") << "[MuonPogTreeProducer]: Vertex collection does not exist !!!";
     }
@@ -245,15 +720,17 @@ void MuonPogTreeProducer::analyze (const edm::Event & ev, const edm::EventSetup
   edm::Handle<reco::BeamSpot> beamSpot;
   if (beamSpotTag_.label() != "none" ) 
     { 
-      if (!ev.getByLabel(beamSpotTag_, beamSpot)) 
+      if (!ev.getByToken(beamSpotToken_, beamSpot)) 
 	edm::LogError("") << "[MuonPogTreeProducer]: Beam spot collection not found !!!";
     }
 
   // Fill (raw) MET information: PF, PF charged, Calo    
+  startStage();
+
   edm::Handle<reco::PFMETCollection> pfMet; 
   if(pfMetTag_.label() != "none") 
     { 
-      if (!ev.getByLabel(pfMetTag_, pfMet)) 
+      if (!ev.getByToken(pfMetToken_, pfMet)) 
 	edm::LogError("") << "[MuonPogTreeProducer] PFMet collection does not exist !!!"; 
       else { 
 	const reco::PFMET &iPfMet = (*pfMet)[0]; 
@@ -264,7 +741,7 @@ void MuonPogTreeProducer::analyze (const edm::Event & ev, const edm::EventSetup
   edm::Handle<reco::PFMETCollection> pfChMet; 
   if(pfChMetTag_.label() != "none") 
     { 
-      if (!ev.getByLabel(pfChMetTag_, pfChMet)) 
+      if (!ev.getByToken(pfChMetToken_, pfChMet)) 
 	edm::LogError("") << "[MuonPogTreeProducer] PFChMet collection does not exist !!!"; 
       else { 
 	const reco::PFMET &iPfChMet = (*pfChMet)[0]; 
@@ -275,7 +752,7 @@ void MuonPogTreeProducer::analyze (const edm::Event & ev, const edm::EventSetup
   edm::Handle<reco::CaloMETCollection> caloMet; 
   if(caloMetTag_.label() != "none") 
     { 
-      if (!ev.getByLabel(caloMetTag_, caloMet)) 
+      if (!ev.getByToken(caloMetToken_, caloMet)) 
 	edm::LogError("") << "[MuonPogTreeProducer] CaloMet collection does not exist !!!"; 
       else { 
 	const reco::CaloMET &iCaloMet = (*caloMet)[0]; 
@@ -283,11 +760,13 @@ void MuonPogTreeProducer::analyze (const edm::Event & ev, const edm::EventSetup
       } 
     } 
 
+  stopStage(MET);
+
   // Get muons  
   edm::Handle<reco::MuonCollection> muons;
   if (muonTag_.label() != "none" ) 
     { 
-      if (!ev.getByLabel(muonTag_, muons)) 
+      if (!ev.getByToken(muonToken_, muons)) 
 	edm::LogError("") << "[MuonPogTreeProducer] Muon collection does not exist !!!";
     }
   
@@ -295,19 +774,134 @@ void MuonPogTreeProducer::analyze (const edm::Event & ev, const edm::EventSetup
   // Fill muon information
   if (muons.isValid() && vertexes.isValid() && beamSpot.isValid()) 
     {
+      startStage();
       fillMuons(muons,vertexes,beamSpot);
+      stopStage(MUONS);
+      hasMuons = true;
     }
+
+  if (!hasGenParticles) event_.genParticles.clear();
+  if (!hasMuons)        event_.muons.clear();
   
+  startStage();
   tree_["muPogTree"]->Fill();
+  stopStage(TREE_FILL);
   
 }
 
 
+bool MuonPogTreeProducer::passSkim(const edm::Event & ev)
+{
+
+  // Muon requirement
+  if (skimMinNMuons_ > 0)
+    {
+      edm::Handle<reco::MuonCollection> muons;
+      edm::Handle<std::vector<reco::Vertex> > vertexes;
+
+      if (muonTag_.label() == "none" || !ev.getByToken(muonToken_, muons))
+	{
+	  skimCounters_->Fill("rejected (muons)",1.);
+	  return false;
+	}
+
+      if (skimMuonID_ == SKIM_ID_TIGHT &&
+	  (primaryVertexTag_.label() == "none" ||
+	   !ev.getByToken(primaryVertexToken_, vertexes) ||
+	   vertexes->empty()))
+	{
+	  skimCounters_->Fill("rejected (muons)",1.);
+	  return false;
+	}
+
+      int nGoodMuons = 0;
+
+      for (auto & mu : *muons)
+	{
+	  if (mu.pt() < skimMuonMinPt_) continue;
+
+	  bool hasID = true;
+
+	  switch (skimMuonID_)
+	    {
+	    case SKIM_ID_NONE   : break;
+	    case SKIM_ID_GLOBAL : hasID = mu.isGlobalMuon(); break;
+	    case SKIM_ID_LOOSE  : hasID = muon::isLooseMuon(mu); break;
+	    case SKIM_ID_MEDIUM : hasID = muon::isMediumMuon(mu); break;
+	    case SKIM_ID_TIGHT  : hasID = muon::isTightMuon(mu,vertexes->at(0)); break;
+	    }
+
+	  if (hasID && ++nGoodMuons >= skimMinNMuons_) break;
+	}
+
+      if (nGoodMuons < skimMinNMuons_)
+	{
+	  skimCounters_->Fill("rejected (muons)",1.);
+	  return false;
+	}
+    }
+
+  // Trigger requirement : any path containing one of the patterns
+  if (!skimHltPaths_.empty())
+    {
+      edm::Handle<edm::TriggerResults> triggerResults;
+
+      if (trigResultsTag_.label() == "none" || !ev.getByToken(trigResultsToken_, triggerResults))
+	{
+	  edm::LogError("") << "[MuonPogTreeProducer]: Trigger results needed by the skim do not exist !!!";
+	  skimCounters_->Fill("rejected (HLT)",1.);
+	  return false;
+	}
+
+      const edm::TriggerNames & triggerNames = ev.triggerNames(*triggerResults);
+
+      // Patterns are matched to path names only when the menu changes
+      if (triggerNames.parameterSetID() != skimTriggerNamesID_)
+	{
+	  skimTriggerNamesID_ = triggerNames.parameterSetID();
+	  skimPathIndices_.clear();
+
+	  for (unsigned int iTrig=0; iTrig<triggerNames.size(); ++iTrig)
+	    {
+	      for (auto & pattern : skimHltPaths_)
+		{
+		  if (triggerNames.triggerName(iTrig).find(pattern) != std::string::npos)
+		    {
+		      skimPathIndices_.push_back(iTrig);
+		      break;
+		    }
+		}
+	    }
+	}
+
+      bool hasFired = false;
+      for (auto iTrig : skimPathIndices_)
+	{
+	  if (triggerResults->accept(iTrig))
+	    {
+	      hasFired = true;
+	      break;
+	    }
+	}
+
+      if (!hasFired)
+	{
+	  skimCounters_->Fill("rejected (HLT)",1.);
+	  return false;
+	}
+    }
+
+  return true;
+
+}
+
+
 void MuonPogTreeProducer::fillGenInfo(const edm::Handle<std::vector<PileupSummaryInfo> > & puInfo,
 				      const edm::Handle<GenEventInfoProduct> & gen)
 {
 
-  muon_pog::GenInfo genInfo;
+  event_.genInfos.emplace_back();
+  muon_pog::GenInfo & genInfo = event_.genInfos.back();
   
   genInfo.trueNumberOfInteractions     = -1.;
   genInfo.actualNumberOfInteractions   = -1.;
@@ -328,8 +922,6 @@ void MuonPogTreeProducer::fillGenInfo(const edm::Handle<std::vector<PileupSummar
 	}
     }
   
-  event_.genInfos.push_back(genInfo);
-  
 }
 
 
@@ -337,14 +929,17 @@ void MuonPogTreeProducer::fillGenParticles(const edm::Handle<reco::GenParticleCo
 {
   
   unsigned int gensize = genParticles->size();
+
+  // Particles are filled in place, reusing the mothers vectors of the previous event
+  event_.genParticles.resize(gensize);
   
   // Do not record the initial protons
   for (unsigned int i=0; i<gensize; ++i) 
     {
 
-      const reco::GenParticle& part = genParticles->at(i);
+      const reco::GenParticle& part = (*genParticles)[i];
     
-      muon_pog::GenParticle gensel;
+      muon_pog::GenParticle & gensel = event_.genParticles[i];
       gensel.pdgId = part.pdgId();
       gensel.status = part.status();
       gensel.energy = part.energy();
@@ -356,17 +951,31 @@ void MuonPogTreeProducer::fillGenParticles(const edm::Handle<reco::GenParticleCo
       gensel.vz = part.vz();
 
       gensel.mothers.clear();
+      gensel.motherIndices.clear();
       unsigned int nMothers = part.numberOfMothers();
 
       for (unsigned int iMother=0; iMother<nMothers; ++iMother) 
 	{
-	  gensel.mothers.push_back(part.motherRef(iMother)->pdgId());
+	  reco::GenParticleRef mother = part.motherRef(iMother);
+	  gensel.mothers.push_back(mother->pdgId());
+	  // mothers outside the stored collection have no index
+	  gensel.motherIndices.push_back(mother.id() == genParticles.id() ? Int_t(mother.key()) : -1);
 	}
 
       // Protect agains bug in genParticles (missing mother => first proton)
-      if (i>=2 && nMothers==0) gensel.mothers.push_back(0);
+      if (i>=2 && nMothers==0)
+	{
+	  gensel.mothers.push_back(0);
+	  gensel.motherIndices.push_back(0);
+	}
+
+      // Matched to reco muons in fillMuons
+      gensel.muonIndex = -1;
+      gensel.muonDr    = -999.;
+
+      if (std::abs(part.pdgId()) == 13 && part.status() == 1)
+	genMuons_.push_back(i);
       
-      event_.genParticles.push_back(gensel);
     }
   
 }
@@ -377,45 +986,76 @@ void MuonPogTreeProducer::fillHlt(const edm::Handle<edm::TriggerResults> & trigg
 				  const edm::TriggerNames & triggerNames)
 {    
 
+  // Paths are stored as bits indexed as in the run HLTNames,
+  // names are only written if the menu doesn't match them
+  if (triggerNames.parameterSetID() != hltTriggerNamesID_)
+    {
+      hltTriggerNamesID_ = triggerNames.parameterSetID();
+      hltNamesMatch_ = triggerNames.triggerNames() == hltNames_.paths;
+
+      if (!hltNamesMatch_)
+	edm::LogWarning("") << "[MuonPogTreeProducer]: Trigger menu doesn't match the run HLT names,"
+			    << " path names are stored in each event";
+    }
+
+  bool hasRunNames = hltNamesMatch_;
+
+  if (hasRunNames)
+    event_.hlt.pathBits.assign((triggerNames.size() + 31) / 32, 0);
+
   for (unsigned int iTrig=0; iTrig<triggerNames.size(); ++iTrig) 
     {
       
       if (triggerResults->accept(iTrig)) 
 	{
-	  std::string pathName = triggerNames.triggerName(iTrig);
-	  event_.hlt.triggers.push_back(pathName);
+	  if (hasRunNames)
+	    event_.hlt.pathBits[iTrig / 32] |= (1u << (iTrig % 32));
+	  else
+	    {
+	      std::string pathName = triggerNames.triggerName(iTrig);
+	      event_.hlt.triggers.push_back(pathName);
+	    }
 	}
     }
       
   const trigger::size_type nFilters(triggerEvent->sizeFilters());
+  const trigger::TriggerObjectCollection& triggerObjects(triggerEvent->getObjects());
+
+  std::size_t nObjects = 0;
+  for (trigger::size_type iFilter=0; iFilter!=nFilters; ++iFilter) 
+    nObjects += triggerEvent->filterKeys(iFilter).size();
+  event_.hlt.objects.reserve(nObjects);
 
   for (trigger::size_type iFilter=0; iFilter!=nFilters; ++iFilter) 
     {
 	
       std::string filterTag = triggerEvent->filterTag(iFilter).encode();
 
-      trigger::Keys objectKeys = triggerEvent->filterKeys(iFilter);
-      const trigger::TriggerObjectCollection& triggerObjects(triggerEvent->getObjects());
+      std::unordered_map<std::string,Int_t>::const_iterator filterIdIt = hltFilterIds_.find(filterTag);
+      Int_t filterId = filterIdIt != hltFilterIds_.end() ? filterIdIt->second : -1;
+
+      const trigger::Keys & objectKeys = triggerEvent->filterKeys(iFilter);
 	
       for (trigger::size_type iKey=0; iKey<objectKeys.size(); ++iKey) 
 	{  
-	  trigger::size_type objKey = objectKeys.at(iKey);
+	  trigger::size_type objKey = objectKeys[iKey];
 	  const trigger::TriggerObject& triggerObj(triggerObjects[objKey]);
 	  
-	  muon_pog::HLTObject hltObj;
+	  event_.hlt.objects.emplace_back();
+	  muon_pog::HLTObject & hltObj = event_.hlt.objects.back();
 	  
 	  float trigObjPt = triggerObj.pt();
 	  float trigObjEta = triggerObj.eta();
 	  float trigObjPhi = triggerObj.phi();
 	  
-	  hltObj.filterTag = filterTag;
+	  hltObj.filterId = filterId;
+	  if (filterId < 0)
+	    hltObj.filterTag = filterTag;
 
 	  hltObj.pt  = trigObjPt;
 	  hltObj.eta = trigObjEta;
 	  hltObj.phi = trigObjPhi;
 	  
-	  event_.hlt.objects.push_back(hltObj);
-	  
 	}       
     }
 
@@ -464,13 +1104,16 @@ void MuonPogTreeProducer::fillMuons(const edm::Handle<reco::MuonCollection> & mu
 				    const edm::Handle<reco::BeamSpot> & beamSpot)
 {
 
-  reco::MuonCollection::const_iterator muonIt  = muons->begin();
-  reco::MuonCollection::const_iterator muonEnd = muons->end();
+  unsigned int nMuons = muons->size();
 
-  for (; muonIt != muonEnd; ++muonIt) 
+  // Muons are filled in place (muon_pog::Muon has no dynamic members)
+  if (storeMuonObjects_)
+    event_.muons.resize(nMuons);
+
+  for (unsigned int iMuon=0; iMuon<nMuons; ++iMuon) 
     {
       
-      const reco::Muon& mu = (*muonIt);
+      const reco::Muon& mu = (*muons)[iMuon];
 
       bool isGlobal      = mu.isGlobalMuon();
       bool isTracker     = mu.isTrackerMuon();
@@ -481,28 +1124,58 @@ void MuonPogTreeProducer::fillMuons(const edm::Handle<reco::MuonCollection> & mu
 
       bool hasInnerTrack = !mu.innerTrack().isNull();
       bool hasTunePTrack = !mu.tunePMuonBestTrack().isNull();
+
+      // Dereference every track only once
+      const reco::Track * globalTrack = isGlobal      ? mu.globalTrack().get()        : 0;
+      const reco::Track * innerTrack  = hasInnerTrack ? mu.innerTrack().get()         : 0;
+      const reco::Track * outerTrack  = isStandAlone  ? mu.outerTrack().get()         : 0;
+      const reco::Track * tunePTrack  = hasTunePTrack ? mu.tunePMuonBestTrack().get() : 0;
+      const reco::Track * bestTrack   = mu.muonBestTrack().get();
       
-      muon_pog::Muon ntupleMu;
+      muon_pog::Muon & ntupleMu = storeMuonObjects_ ? event_.muons[iMuon] : muonBuffer_;
       
       ntupleMu.pt     = mu.pt();
       ntupleMu.eta    = mu.eta();
       ntupleMu.phi    = mu.phi();
       ntupleMu.charge = mu.charge();
 
-      ntupleMu.pt_global     = isGlobal ? mu.globalTrack()->pt()  : -1000.;
-      ntupleMu.eta_global    = isGlobal ? mu.globalTrack()->eta() : -1000.;
-      ntupleMu.phi_global    = isGlobal ? mu.globalTrack()->phi() : -1000.;
-      ntupleMu.charge_global = isGlobal ? mu.globalTrack()->charge() : -1000.;
+      // Closest gen muon in dR, gen muons keep their closest reco muon
+      ntupleMu.genIndex = -1;
+      ntupleMu.genDr    = -999.;
+
+      for (auto iGen : genMuons_)
+	{
+	  muon_pog::GenParticle & genMu = event_.genParticles[iGen];
+	  Float_t dr = reco::deltaR(genMu.eta, genMu.phi, ntupleMu.eta, ntupleMu.phi);
+	  if (dr >= genMatchMaxDr_) continue;
+
+	  if (ntupleMu.genIndex < 0 || dr < ntupleMu.genDr)
+	    {
+	      ntupleMu.genIndex = iGen;
+	      ntupleMu.genDr    = dr;
+	    }
+
+	  if (genMu.muonIndex < 0 || dr < genMu.muonDr)
+	    {
+	      genMu.muonIndex = iMuon;
+	      genMu.muonDr    = dr;
+	    }
+	}
+
+      ntupleMu.pt_global     = isGlobal ? globalTrack->pt()  : -1000.;
+      ntupleMu.eta_global    = isGlobal ? globalTrack->eta() : -1000.;
+      ntupleMu.phi_global    = isGlobal ? globalTrack->phi() : -1000.;
+      ntupleMu.charge_global = isGlobal ? globalTrack->charge() : -1000.;
 
-      ntupleMu.pt_tuneP     = hasTunePTrack ? mu.tunePMuonBestTrack()->pt()  : -1000.;
-      ntupleMu.eta_tuneP    = hasTunePTrack ? mu.tunePMuonBestTrack()->eta() : -1000.;
-      ntupleMu.phi_tuneP    = hasTunePTrack ? mu.tunePMuonBestTrack()->phi() : -1000.;
-      ntupleMu.charge_tuneP = hasTunePTrack ? mu.tunePMuonBestTrack()->charge() : -1000.;
+      ntupleMu.pt_tuneP     = hasTunePTrack ? tunePTrack->pt()  : -1000.;
+      ntupleMu.eta_tuneP    = hasTunePTrack ? tunePTrack->eta() : -1000.;
+      ntupleMu.phi_tuneP    = hasTunePTrack ? tunePTrack->phi() : -1000.;
+      ntupleMu.charge_tuneP = hasTunePTrack ? tunePTrack->charge() : -1000.;
 
-      ntupleMu.pt_tracker     = hasInnerTrack ? mu.innerTrack()->pt()  : -1000.;
-      ntupleMu.eta_tracker    = hasInnerTrack ? mu.innerTrack()->eta() : -1000.;
-      ntupleMu.phi_tracker    = hasInnerTrack ? mu.innerTrack()->phi() : -1000.;
-      ntupleMu.charge_tracker = hasInnerTrack ? mu.innerTrack()->charge() : -1000.;
+      ntupleMu.pt_tracker     = hasInnerTrack ? innerTrack->pt()  : -1000.;
+      ntupleMu.eta_tracker    = hasInnerTrack ? innerTrack->eta() : -1000.;
+      ntupleMu.phi_tracker    = hasInnerTrack ? innerTrack->phi() : -1000.;
+      ntupleMu.charge_tracker = hasInnerTrack ? innerTrack->charge() : -1000.;
 
       reco::MuonPFIsolation iso04 = mu.pfIsolationR04();
       reco::MuonPFIsolation iso03 = mu.pfIsolationR03();
@@ -519,27 +1192,27 @@ void MuonPogTreeProducer::fillMuons(const edm::Handle<reco::MuonCollection> & mu
       ntupleMu.isStandAlone = isStandAlone ? 1 : 0;
       ntupleMu.isPF         = isPF ? 1 : 0;
 
-      ntupleMu.nHitsGlobal     = isGlobal     ? mu.globalTrack()->numberOfValidHits() : -999;	
-      ntupleMu.nHitsTracker    = isTracker    ? mu.innerTrack()->numberOfValidHits()  : -999;	
-      ntupleMu.nHitsStandAlone = isStandAlone ? mu.outerTrack()->numberOfValidHits()  : -999;
+      ntupleMu.nHitsGlobal     = isGlobal     ? globalTrack->numberOfValidHits() : -999;	
+      ntupleMu.nHitsTracker    = isTracker    ? innerTrack->numberOfValidHits()  : -999;	
+      ntupleMu.nHitsStandAlone = isStandAlone ? outerTrack->numberOfValidHits()  : -999;
 
-      ntupleMu.glbNormChi2              = isGlobal      ? mu.globalTrack()->normalizedChi2() : -999; 
-      ntupleMu.trkNormChi2	        = hasInnerTrack ? mu.innerTrack()->normalizedChi2()  : -999; 
+      ntupleMu.glbNormChi2              = isGlobal      ? globalTrack->normalizedChi2() : -999; 
+      ntupleMu.trkNormChi2	        = hasInnerTrack ? innerTrack->normalizedChi2()  : -999; 
       ntupleMu.trkMuonMatchedStations   = isTracker     ? mu.numberOfMatchedStations()       : -999; 
-      ntupleMu.glbMuonValidHits	        = isGlobal      ? mu.globalTrack()->hitPattern().numberOfValidMuonHits()       : -999; 
-      ntupleMu.trkPixelValidHits	= hasInnerTrack ? mu.innerTrack()->hitPattern().numberOfValidPixelHits()       : -999; 
-      ntupleMu.trkPixelLayersWithMeas   = hasInnerTrack ? mu.innerTrack()->hitPattern().pixelLayersWithMeasurement()   : -999; 
-      ntupleMu.trkTrackerLayersWithMeas = hasInnerTrack ? mu.innerTrack()->hitPattern().trackerLayersWithMeasurement() : -999; 
+      ntupleMu.glbMuonValidHits	        = isGlobal      ? globalTrack->hitPattern().numberOfValidMuonHits()       : -999; 
+      ntupleMu.trkPixelValidHits	= hasInnerTrack ? innerTrack->hitPattern().numberOfValidPixelHits()       : -999; 
+      ntupleMu.trkPixelLayersWithMeas   = hasInnerTrack ? innerTrack->hitPattern().pixelLayersWithMeasurement()   : -999; 
+      ntupleMu.trkTrackerLayersWithMeas = hasInnerTrack ? innerTrack->hitPattern().trackerLayersWithMeasurement() : -999; 
 
-      ntupleMu.bestMuPtErr              = mu.muonBestTrack()->ptError(); 
+      ntupleMu.bestMuPtErr              = bestTrack->ptError(); 
 
-      ntupleMu.trkValidHitFrac = hasInnerTrack           ? mu.innerTrack()->validFraction()       : -999; 
+      ntupleMu.trkValidHitFrac = hasInnerTrack           ? innerTrack->validFraction()       : -999; 
       ntupleMu.trkStaChi2      = isGlobal                ? mu.combinedQuality().chi2LocalPosition : -999; 
       ntupleMu.trkKink         = isGlobal                ? mu.combinedQuality().trkKink           : -999; 
       ntupleMu.muSegmComp      = (isGlobal || isTracker) ? muon::segmentCompatibility(mu)         : -999; 
 
       ntupleMu.isTrkMuOST               = muon::isGoodMuon(mu, muon::TMOneStationTight) ? 1 : 0; 
-      ntupleMu.isTrkHP                  = hasInnerTrack && mu.innerTrack()->quality(reco::TrackBase::highPurity) ? 1 : 0; 
+      ntupleMu.isTrkHP                  = hasInnerTrack && innerTrack->quality(reco::TrackBase::highPurity) ? 1 : 0; 
 
       ntupleMu.dxyBest  = -999; 
       ntupleMu.dzBest   = -999; 
@@ -552,10 +1225,10 @@ void MuonPogTreeProducer::fillMuons(const edm::Handle<reco::MuonCollection> & mu
 
       const reco::Vertex & vertex = vertexes->at(0); // CB for now vertex is always valid, but add a protection	    
       
-      double dxybs = isGlobal ? mu.globalTrack()->dxy(beamSpot->position()) :
-	hasInnerTrack ? mu.innerTrack()->dxy(beamSpot->position()) : -1000;
-      double dzbs  = isGlobal ? mu.globalTrack()->dz(beamSpot->position()) :
-	hasInnerTrack ? mu.innerTrack()->dz(beamSpot->position()) : -1000;
+      double dxybs = isGlobal ? globalTrack->dxy(beamSpot->position()) :
+	hasInnerTrack ? innerTrack->dxy(beamSpot->position()) : -1000;
+      double dzbs  = isGlobal ? globalTrack->dz(beamSpot->position()) :
+	hasInnerTrack ? innerTrack->dz(beamSpot->position()) : -1000;
 
       double dxy = -1000.;
       double dz  = -1000.;
@@ -570,16 +1243,16 @@ void MuonPogTreeProducer::fillMuons(const edm::Handle<reco::MuonCollection> & mu
 	{
 	  const reco::Vertex & vertex = vertexes->at(0);
 
-	  dxy = isGlobal ? mu.globalTrack()->dxy(vertex.position()) :
-	    hasInnerTrack ? mu.innerTrack()->dxy(vertex.position()) : -1000;
-	  dz = isGlobal ? mu.globalTrack()->dz(vertex.position()) :
-	    hasInnerTrack ? mu.innerTrack()->dz(vertex.position()) : -1000;
+	  dxy = isGlobal ? globalTrack->dxy(vertex.position()) :
+	    hasInnerTrack ? innerTrack->dxy(vertex.position()) : -1000;
+	  dz = isGlobal ? globalTrack->dz(vertex.position()) :
+	    hasInnerTrack ? innerTrack->dz(vertex.position()) : -1000;
  
-	  ntupleMu.dxyBest  = mu.muonBestTrack()->dxy(vertex.position()); 
-	  ntupleMu.dzBest   = mu.muonBestTrack()->dz(vertex.position()); 
+	  ntupleMu.dxyBest  = bestTrack->dxy(vertex.position()); 
+	  ntupleMu.dzBest   = bestTrack->dz(vertex.position()); 
 	  if(hasInnerTrack) { 
-	    ntupleMu.dxyInner = mu.innerTrack()->dxy(vertex.position()); 
-	    ntupleMu.dzInner  = mu.innerTrack()->dz(vertex.position()); 
+	    ntupleMu.dxyInner = innerTrack->dxy(vertex.position()); 
+	    ntupleMu.dzInner  = innerTrack->dz(vertex.position()); 
 	  } 
 
 	  ntupleMu.isSoft    = muon::isSoftMuon(mu,vertex)   ? 1 : 0;	  
@@ -590,8 +1263,8 @@ void MuonPogTreeProducer::fillMuons(const edm::Handle<reco::MuonCollection> & mu
 
       ntupleMu.dxy    = dxy;
       ntupleMu.dz     = dz;
-      ntupleMu.edxy   = isGlobal ? mu.globalTrack()->dxyError() : hasInnerTrack ? mu.innerTrack()->dxyError() : -1000;
-      ntupleMu.edz    = isGlobal ? mu.globalTrack()->dzError()  : hasInnerTrack ? mu.innerTrack()->dzError() : -1000;
+      ntupleMu.edxy   = isGlobal ? globalTrack->dxyError() : hasInnerTrack ? innerTrack->dxyError() : -1000;
+      ntupleMu.edz    = isGlobal ? globalTrack->dzError()  : hasInnerTrack ? innerTrack->dzError() : -1000;
 
       ntupleMu.dxybs  = dxybs;
       ntupleMu.dzbs   = dzbs;
@@ -607,7 +1280,9 @@ void MuonPogTreeProducer::fillMuons(const edm::Handle<reco::MuonCollection> & mu
 	ntupleMu.muonTimeErr = -999; 
       } 
 
-      event_.muons.push_back(ntupleMu);
+      if (storeMuonColumns_ && !muonColumns_.push_back(ntupleMu))
+	edm::LogWarning("") << "[MuonPogTreeProducer]: More than " << muon_pog::MuonColumns::kMaxMuons
+			    << " muons, not all of them are stored in the muon columns !!!";
 
     }
 
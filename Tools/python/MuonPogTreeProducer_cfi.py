@@ -14,7 +14,33 @@ MuonPogTree = cms.EDAnalyzer("MuonPogTreeProducer",
 
                              GenTag = cms.untracked.InputTag("prunedGenParticles"), # pruned
                              PileUpInfoTag = cms.untracked.InputTag("addPileupInfo"),
-                             GenInfoTag = cms.untracked.InputTag("generator")
+                             GenInfoTag = cms.untracked.InputTag("generator"),
+                             GenMatchMaxDr = cms.untracked.double(0.2), # max dR of the gen <-> reco muon matches
+
+                             # Skim : store only events with at least SkimMinNMuons muons with
+                             # pt > SkimMuonMinPt and SkimMuonID (NONE, GLOBAL, LOOSE, MEDIUM, TIGHT)
+                             # firing a path containing one of SkimHltPaths (no requirement if empty)
+                             SkimMinNMuons = cms.untracked.int32(0),
+                             SkimMuonMinPt = cms.untracked.double(0.),
+                             SkimMuonID    = cms.untracked.string("NONE"),
+                             SkimHltPaths  = cms.untracked.vstring(),
+
+                             FillStats = cms.untracked.bool(False), # count allocations per fill stage, printed at endJob
+                             StatsTree = cms.untracked.bool(False), # store fill stages times and branch sizes in the MUONPOGSTATS tree
+
+                             # Output tree : Compression (DEFAULT keeps the TFileService file settings,
+                             # ZLIB, LZMA, LZ4 or ZSTD with ROOT >= 6.20) and CompressionLevel (0 to 9,
+                             # -1 for the ROOT default of the algorithm), e.g. LZ4 for ntuples read
+                             # many times and LZMA for archival ones. AutoFlush is the number of
+                             # entries per cluster (> 0) or of bytes written between flushes (< 0)
+                             Compression      = cms.untracked.string("DEFAULT"),
+                             CompressionLevel = cms.untracked.int32(-1),
+                             BasketSize       = cms.untracked.int32(64000),
+                             SplitLevel       = cms.untracked.int32(2),
+                             AutoFlush        = cms.untracked.int64(-30000000),
+
+                             StoreMuonObjects = cms.untracked.bool(True),  # std::vector<muon_pog::Muon> in the event branch
+                             StoreMuonColumns = cms.untracked.bool(False)  # one muons_<member>[nMuons] branch per muon_pog::Muon member
                              )
 
 
@@ -0,0 +1,178 @@
+#ifndef MuonPOG_Tools_DimuonPairs_H
+#define MuonPOG_Tools_DimuonPairs_H
+
+#include "Rtypes.h"
+
+#include <cmath>
+#include <vector>
+
+namespace muon_pog {
+
+  const Double_t kMuonMass = .10565; // [GeV]
+
+  // Kinematics of the muons of one event as columns : pt, eta, phi
+  // and charge as given, px, py, pz and energy computed once per muon
+  // (same conventions as TLorentzVector::SetPtEtaPhiM)
+  class MuonKinematics {
+
+  public :
+
+    std::vector<Double_t> pt;
+    std::vector<Double_t> eta;
+    std::vector<Double_t> phi;
+    std::vector<Int_t>    charge;
+
+    std::vector<Double_t> px;
+    std::vector<Double_t> py;
+    std::vector<Double_t> pz;
+    std::vector<Double_t> energy;
+
+    void clear()
+    {
+      pt.clear(); eta.clear(); phi.clear(); charge.clear();
+      px.clear(); py.clear(); pz.clear(); energy.clear();
+    }
+
+    UInt_t size() const { return pt.size(); };
+
+    void push_back(Double_t muPt, Double_t muEta, Double_t muPhi, Int_t muCharge,
+		   Double_t mass = kMuonMass)
+    {
+      pt.push_back(muPt);
+      eta.push_back(muEta);
+      phi.push_back(muPhi);
+      charge.push_back(muCharge);
+
+      Double_t absPt = std::fabs(muPt);
+      Double_t muPx  = absPt * std::cos(muPhi);
+      Double_t muPy  = absPt * std::sin(muPhi);
+      Double_t muPz  = absPt * std::sinh(muEta);
+
+      px.push_back(muPx);
+      py.push_back(muPy);
+      pz.push_back(muPz);
+      energy.push_back(std::sqrt(muPx * muPx + muPy * muPy + muPz * muPz + mass * mass));
+    }
+
+    // Fill from column arrays (e.g. muon_pog::MuonColumns) of nMuons entries
+    void fill(const Float_t * muPt, const Float_t * muEta, const Float_t * muPhi,
+	      const Int_t * muCharge, Int_t nMuons, Double_t mass = kMuonMass)
+    {
+      clear();
+      for (Int_t iMuon = 0; iMuon < nMuons; ++iMuon)
+	push_back(muPt[iMuon], muEta[iMuon], muPhi[iMuon], muCharge[iMuon], mass);
+    }
+
+  };
+
+  // Opposite charge muon pairs of one event, every pair is given by the
+  // indices of its muons in MuonKinematics, the dimuon quantities are
+  // computed in one pass over contiguous arrays, which the compiler
+  // can vectorize. M() and Rapidity() follow TLorentzVector conventions
+  class DimuonPairs {
+
+  public :
+
+    std::vector<UInt_t> first;
+    std::vector<UInt_t> second;
+
+    std::vector<Double_t> mass;
+    std::vector<Double_t> rapidity;
+    std::vector<Double_t> pt;
+
+    UInt_t size() const { return first.size(); };
+
+    // All opposite charge pairs (i,j) with i < j
+    void build(const muon_pog::MuonKinematics & muons)
+    {
+      first.clear();
+      second.clear();
+
+      UInt_t nMuons = muons.size();
+      for (UInt_t iMu1 = 0; iMu1 < nMuons; ++iMu1)
+	{
+	  for (UInt_t iMu2 = iMu1 + 1; iMu2 < nMuons; ++iMu2)
+	    {
+	      if (muons.charge[iMu1] * muons.charge[iMu2] != -1) continue;
+	      first.push_back(iMu1);
+	      second.push_back(iMu2);
+	    }
+	}
+
+      compute(muons);
+    }
+
+    // Opposite charge pairs of a muon from firstMuons with any muon,
+    // ordered by the second muon and then as in firstMuons
+    void build(const muon_pog::MuonKinematics & muons,
+	       const std::vector<UInt_t> & firstMuons)
+    {
+      first.clear();
+      second.clear();
+
+      UInt_t nMuons = muons.size();
+      for (UInt_t iMu2 = 0; iMu2 < nMuons; ++iMu2)
+	{
+	  for (auto iMu1 : firstMuons)
+	    {
+	      if (muons.charge[iMu1] * muons.charge[iMu2] != -1) continue;
+	      first.push_back(iMu1);
+	      second.push_back(iMu2);
+	    }
+	}
+
+      compute(muons);
+    }
+
+  private :
+
+    void compute(const muon_pog::MuonKinematics & muons)
+    {
+      UInt_t nPairs = first.size();
+
+      // gather the pair four-momenta
+      m_px.resize(nPairs);
+      m_py.resize(nPairs);
+      m_pz.resize(nPairs);
+      m_energy.resize(nPairs);
+
+      for (UInt_t iPair = 0; iPair < nPairs; ++iPair)
+	{
+	  UInt_t iMu1 = first[iPair];
+	  UInt_t iMu2 = second[iPair];
+	  m_px[iPair]     = muons.px[iMu1] + muons.px[iMu2];
+	  m_py[iPair]     = muons.py[iMu1] + muons.py[iMu2];
+	  m_pz[iPair]     = muons.pz[iMu1] + muons.pz[iMu2];
+	  m_energy[iPair] = muons.energy[iMu1] + muons.energy[iMu2];
+	}
+
+      mass.resize(nPairs);
+      rapidity.resize(nPairs);
+      pt.resize(nPairs);
+
+      const Double_t * px = m_px.data();
+      const Double_t * py = m_py.data();
+      const Double_t * pz = m_pz.data();
+      const Double_t * e  = m_energy.data();
+
+      for (UInt_t iPair = 0; iPair < nPairs; ++iPair)
+	{
+	  Double_t pt2   = px[iPair] * px[iPair] + py[iPair] * py[iPair];
+	  Double_t mass2 = e[iPair] * e[iPair] - pt2 - pz[iPair] * pz[iPair];
+
+	  mass[iPair]     = mass2 < 0. ? -std::sqrt(-mass2) : std::sqrt(mass2);
+	  rapidity[iPair] = .5 * std::log((e[iPair] + pz[iPair]) / (e[iPair] - pz[iPair]));
+	  pt[iPair]       = std::sqrt(pt2);
+	}
+    }
+
+    // pair four-momenta, reused across events
+    std::vector<Double_t> m_px;
+    std::vector<Double_t> m_py;
+    std::vector<Double_t> m_pz;
+    std::vector<Double_t> m_energy;
+
+  };
+
+}
+#endif
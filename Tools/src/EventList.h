@@ -0,0 +1,262 @@
+#ifndef MuonPOG_Tools_EventList_H
+#define MuonPOG_Tools_EventList_H
+
+#include "MuonPogTree.h"
+#include "ReaderUtils.h"
+
+#include "TFile.h"
+#include "TString.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace muon_pog {
+
+  // Run, luminosity block and event number of one event, 64 bits
+  // unsigned as edm::EventID (event numbers can exceed 2^31)
+  class EventKey {
+
+  public :
+
+    ULong64_t runNumber;
+    ULong64_t luminosityBlockNumber;
+    ULong64_t eventNumber;
+
+    EventKey(ULong64_t run = 0, ULong64_t lumi = 0, ULong64_t event = 0) :
+      runNumber(run), luminosityBlockNumber(lumi), eventNumber(event) {};
+
+    bool operator==(const EventKey & other) const
+    {
+      return runNumber == other.runNumber &&
+	     luminosityBlockNumber == other.luminosityBlockNumber &&
+	     eventNumber == other.eventNumber;
+    }
+
+  };
+
+  class EventKeyHash {
+
+  public :
+
+    std::size_t operator()(const EventKey & key) const
+    {
+      std::size_t hash = std::hash<ULong64_t>()(key.runNumber);
+      hash ^= std::hash<ULong64_t>()(key.luminosityBlockNumber) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      hash ^= std::hash<ULong64_t>()(key.eventNumber) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      return hash;
+    }
+
+  };
+
+  // List of events given as run:lumi:event, either as a comma separated
+  // string or as a text file with one event per line (# for comments).
+  // Membership is checked with a hash set, the list keeps the input order.
+  // read() exits on errors (macros), tryRead() returns them (plugins)
+  class EventList {
+
+  public :
+
+    // Add one run:lumi:event entry, false if it is malformed
+    bool add(const std::string & entry)
+    {
+      std::stringstream fields(entry);
+      ULong64_t run, lumi, event;
+      char sep1 = 0, sep2 = 0;
+
+      if (entry.find('-') != std::string::npos || // no negative numbers
+	  !(fields >> run >> sep1 >> lumi >> sep2 >> event) ||
+	  sep1 != ':' || sep2 != ':')
+	return false;
+
+      EventKey key(run, lumi, event);
+      if (m_keys.insert(key).second)
+	m_events.push_back(key);
+
+      return true;
+    }
+
+    // Comma separated list of run:lumi:event, false and
+    // error set if an entry is malformed
+    bool parse(const std::string & list, std::string & error)
+    {
+      std::stringstream entries(list);
+      std::string entry;
+      while (std::getline(entries, entry, ','))
+	if (!addEntry(entry, error))
+	  return false;
+
+      return true;
+    }
+
+    // Text file with one run:lumi:event per line, false and
+    // error set if it can't be read or an entry is malformed
+    bool load(const std::string & fileName, std::string & error)
+    {
+      std::ifstream file(fileName.c_str());
+      if (!file)
+	{
+	  error = "Can't open event list : " + fileName;
+	  return false;
+	}
+
+      std::string line;
+      while (std::getline(file, line))
+	{
+	  line = line.substr(0, line.find('#'));
+	  if (!addEntry(line, error))
+	    return false;
+	}
+
+      return true;
+    }
+
+    // A file name if it exists, a comma separated list otherwise
+    bool tryRead(const std::string & fileOrList, std::string & error)
+    {
+      if (std::ifstream(fileOrList.c_str()))
+	return load(fileOrList, error);
+      else
+	return parse(fileOrList, error);
+    }
+
+    // Same, exits on errors
+    void read(const std::string & fileOrList)
+    {
+      std::string error;
+      if (!tryRead(fileOrList, error))
+	{
+	  std::cout << "[EventList]: " << error << std::endl;
+	  exit(900);
+	}
+    }
+
+    bool contains(ULong64_t run, ULong64_t lumi, ULong64_t event) const
+    {
+      return m_keys.count(EventKey(run, lumi, event)) > 0;
+    }
+
+    bool empty() const { return m_events.empty(); };
+    std::size_t size() const { return m_events.size(); };
+
+    const std::vector<EventKey> & events() const { return m_events; };
+
+  private :
+
+    bool addEntry(const std::string & entry, std::string & error)
+    {
+      if (TString(entry).Strip(TString::kBoth).IsNull())
+	return true;
+
+      if (!add(entry))
+	{
+	  error = "Invalid entry (run:lumi:event expected) : " + entry;
+	  return false;
+	}
+
+      return true;
+    }
+
+    std::unordered_set<EventKey, EventKeyHash> m_keys;
+    std::vector<EventKey> m_events;
+
+  };
+
+  // Position of an event in a list of ntuple files
+  class EventEntry {
+
+  public :
+
+    EventKey key;
+    UInt_t   fileIndex; // index in the list of files given to findEvents
+    Long64_t entry;     // entry in the tree of that file
+
+  };
+
+  // Find the entries of the events of a list in a set of ntuple files.
+  // Lookups use the run/event TTreeIndex built by MuonPogTreeProducer,
+  // so every file costs one binary search per event. For ntuples written
+  // without index it is built on the fly, which reads the eventId branch
+  // once. Luminosity blocks are checked reading only the eventId branch
+  // of the entries found. Events are returned in file and entry order
+  inline std::vector<muon_pog::EventEntry> findEvents(const std::vector<TString> & fileNames,
+						      const muon_pog::EventList & events)
+  {
+    std::vector<muon_pog::EventEntry> found;
+
+    for (UInt_t iFile = 0; iFile < fileNames.size(); ++iFile)
+      {
+	TFile * file = TFile::Open(fileNames[iFile],"READONLY");
+	if (!file) continue;
+
+	TTree * tree = 0;
+	file->GetObject(muon_pog::treePath(fileNames[iFile]),tree);
+
+	if (!tree || !tree->GetBranch("eventId"))
+	  {
+	    std::cout << "[findEvents]: No MUONPOGTREE with eventId branch in "
+		      << fileNames[iFile] << ", skipping it" << std::endl;
+	    file->Close();
+	    delete file;
+	    continue;
+	  }
+
+	if (!tree->GetTreeIndex())
+	  {
+	    std::cout << "[findEvents]: No event index in " << fileNames[iFile]
+		      << ", building it" << std::endl;
+	    tree->BuildIndex("eventId.runNumber","eventId.eventNumber");
+	  }
+
+	tree->SetBranchStatus("*",0);
+	tree->SetBranchStatus("eventId*",1);
+
+	muon_pog::EventId * eventId = new muon_pog::EventId();
+	tree->SetBranchAddress("eventId",&eventId);
+
+	std::vector<muon_pog::EventEntry> fileEvents;
+
+	for (auto & key : events.events())
+	  {
+	    Long64_t entry = tree->GetEntryNumberWithIndex(Long64_t(key.runNumber),
+							   Long64_t(key.eventNumber));
+	    if (entry < 0) continue;
+
+	    tree->GetEntry(entry);
+	    if (ULong64_t(eventId->luminosityBlockNumber) != key.luminosityBlockNumber)
+	      continue;
+
+	    muon_pog::EventEntry eventEntry;
+	    eventEntry.key = key;
+	    eventEntry.fileIndex = iFile;
+	    eventEntry.entry = entry;
+	    fileEvents.push_back(eventEntry);
+	  }
+
+	std::sort(fileEvents.begin(), fileEvents.end(),
+		  [](const muon_pog::EventEntry & a, const muon_pog::EventEntry & b)
+		  { return a.entry < b.entry; });
+	found.insert(found.end(), fileEvents.begin(), fileEvents.end());
+
+	tree->ResetBranchAddresses();
+	delete eventId;
+
+	file->Close();
+	delete file;
+      }
+
+    std::cout << "[findEvents]: Found " << found.size() << " out of "
+	      << events.size() << " events" << std::endl;
+
+    return found;
+  }
+
+}
+#endif
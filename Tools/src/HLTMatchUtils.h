@@ -0,0 +1,216 @@
+#ifndef MuonPOG_Tools_HLTMatchUtils_H
+#define MuonPOG_Tools_HLTMatchUtils_H
+
+#include "MuonPogTree.h"
+
+#include "TMath.h"
+#include "TVector2.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace muon_pog {
+
+  // Per-event index of the HLT objects used for trigger matching.
+  //
+  // Filters are registered once with addFilter() (a filter matches every
+  // filterTag containing it, as in std::string::find) and give back an ID.
+  // Object filter tags are interned : the substring test is done once per
+  // distinct filterTag (or once per run HLTNames::filters entry for objects
+  // storing a filterId), then objects are only grouped by filter ID.
+  // Within a filter, objects are bucketed in an eta/phi grid with cells as
+  // large as the deltaR cut, so a query only looks at the 3x3 neighbouring
+  // cells, whatever the number of HLT objects in the event.
+
+  class HLTObjectIndex {
+
+  public :
+
+    HLTObjectIndex() : m_runNames(0), m_runNumber(-1) {};
+
+    // Register a filter (sub)string and the deltaR cut used to match it
+    unsigned int addFilter(const std::string & filter, Double_t drCut)
+    {
+      // the cut sets the cell size, it has to be positive
+      if (!(drCut > 0.))
+	{
+	  std::cout << "[HLTObjectIndex::addFilter]: Invalid deltaR cut for filter "
+		    << filter << " : " << drCut << std::endl;
+	  exit(900);
+	}
+
+      FilterBuckets buckets;
+      buckets.filter = filter;
+      buckets.drCut  = drCut;
+      buckets.nPhiCells = std::max(1, int(TMath::TwoPi() / drCut));
+      buckets.phiCellSize = TMath::TwoPi() / buckets.nPhiCells;
+
+      m_filters.push_back(buckets);
+      m_tagFilters.clear(); // interned tags have to be matched to the new filter too
+      m_runNames = 0;
+
+      return m_filters.size() - 1;
+    }
+
+    // Rebuild the index from the objects of a new event
+    void fill(const muon_pog::HLT & hlt)
+    {
+      for (auto & buckets : m_filters)
+	buckets.objects.clear();
+
+      for (auto & object : hlt.objects)
+	{
+	  const std::vector<unsigned int> & filterIds =
+	    hlt.names && object.filterId >= 0 ? runFilters(*hlt.names, object.filterId) :
+	                                        tagFilters(object.filterTag);
+
+	  for (auto filterId : filterIds)
+	    {
+	      FilterBuckets & buckets = m_filters[filterId];
+
+	      Object entry;
+	      entry.eta  = object.eta;
+	      entry.phi  = object.phi;
+	      entry.cell = buckets.cell(buckets.etaCell(object.eta),
+					buckets.phiCell(object.phi));
+	      buckets.objects.push_back(entry);
+	    }
+	}
+
+      for (auto & buckets : m_filters)
+	std::sort(buckets.objects.begin(), buckets.objects.end());
+    }
+
+    // True if an object passing the filter is within the deltaR cut
+    bool match(unsigned int filterId, Double_t eta, Double_t phi) const
+    {
+      const FilterBuckets & buckets = m_filters[filterId];
+      if (buckets.objects.empty()) return false;
+
+      Long64_t etaCell = buckets.etaCell(eta);
+      Int_t    phiCell = buckets.phiCell(phi);
+      Double_t drCut2  = buckets.drCut * buckets.drCut;
+
+      // with less than 3 phi cells neighbours wrap on the same cells
+      Int_t nPhiNeighbours = std::min(3, buckets.nPhiCells);
+
+      for (Long64_t iEta = etaCell - 1; iEta <= etaCell + 1; ++iEta)
+	{
+	  for (Int_t iPhi = 0; iPhi < nPhiNeighbours; ++iPhi)
+	    {
+	      Int_t phiNeighbour = (phiCell - 1 + iPhi + buckets.nPhiCells) % buckets.nPhiCells;
+	      Long64_t cell = buckets.cell(iEta, phiNeighbour);
+
+	      Object cellBegin;
+	      cellBegin.cell = cell;
+	      cellBegin.eta  = -std::numeric_limits<Float_t>::max();
+	      cellBegin.phi  = -std::numeric_limits<Float_t>::max();
+
+	      for (auto objIt = std::lower_bound(buckets.objects.begin(),
+						 buckets.objects.end(), cellBegin);
+		   objIt != buckets.objects.end() && objIt->cell == cell; ++objIt)
+		{
+		  Double_t dEta = eta - objIt->eta;
+		  Double_t dPhi = TVector2::Phi_mpi_pi(phi - objIt->phi);
+
+		  if (dEta * dEta + dPhi * dPhi < drCut2)
+		    return true;
+		}
+	    }
+	}
+
+      return false;
+    }
+
+  private :
+
+    class Object {
+    public :
+      Long64_t cell;
+      Float_t  eta;
+      Float_t  phi;
+
+      bool operator<(const Object & other) const
+      {
+	return cell != other.cell ? cell < other.cell :
+	       eta  != other.eta  ? eta  < other.eta  : phi < other.phi;
+      }
+    };
+
+    class FilterBuckets {
+    public :
+      std::string filter;
+      Double_t drCut;
+      Int_t    nPhiCells;
+      Double_t phiCellSize;
+      std::vector<Object> objects; // sorted by cell
+
+      Long64_t etaCell(Double_t eta) const { return Long64_t(std::floor(eta / drCut)); };
+      Int_t phiCell(Double_t phi) const
+      {
+	Int_t iCell = Int_t(std::floor((TVector2::Phi_mpi_pi(phi) + TMath::Pi()) / phiCellSize));
+	return std::min(std::max(iCell,0), nPhiCells - 1);
+      };
+      Long64_t cell(Long64_t iEta, Int_t iPhi) const { return iEta * nPhiCells + iPhi; };
+    };
+
+    // IDs of the registered filters matching a given filterTag
+    const std::vector<unsigned int> & tagFilters(const std::string & filterTag)
+    {
+      auto tagIt = m_tagFilters.find(filterTag);
+      if (tagIt != m_tagFilters.end())
+	return tagIt->second;
+
+      std::vector<unsigned int> & filterIds = m_tagFilters[filterTag];
+      for (unsigned int iFilter = 0; iFilter < m_filters.size(); ++iFilter)
+	{
+	  if (filterTag.find(m_filters[iFilter].filter) != std::string::npos)
+	    filterIds.push_back(iFilter);
+	}
+
+      return filterIds;
+    }
+
+    // IDs of the registered filters matching a given entry of the run filter names
+    const std::vector<unsigned int> & runFilters(const muon_pog::HLTNames & names, Int_t filterId)
+    {
+      if (&names != m_runNames || names.runNumber != m_runNumber)
+	{
+	  m_runNames  = &names;
+	  m_runNumber = names.runNumber;
+	  m_runFilters.assign(names.filters.size(), std::vector<unsigned int>());
+	  m_runFiltersDone.assign(names.filters.size(), false);
+	}
+
+      if (filterId >= Int_t(m_runFilters.size()))
+	return m_noFilters;
+
+      if (!m_runFiltersDone[filterId])
+	{
+	  m_runFilters[filterId] = tagFilters(names.filters[filterId]);
+	  m_runFiltersDone[filterId] = true;
+	}
+
+      return m_runFilters[filterId];
+    }
+
+    std::vector<FilterBuckets> m_filters;
+    std::unordered_map<std::string, std::vector<unsigned int> > m_tagFilters;
+
+    const muon_pog::HLTNames * m_runNames;
+    Int_t m_runNumber;
+    std::vector<std::vector<unsigned int> > m_runFilters;
+    std::vector<bool> m_runFiltersDone;
+    std::vector<unsigned int> m_noFilters;
+
+  };
+
+}
+#endif
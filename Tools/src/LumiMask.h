@@ -0,0 +1,143 @@
+#ifndef MuonPOG_Tools_LumiMask_H
+#define MuonPOG_Tools_LumiMask_H
+
+#include "MuonPogTree.h"
+
+#include "TTree.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/exceptions.hpp>
+
+namespace muon_pog {
+
+  // Certified luminosity sections, loaded from a CMS JSON file
+  // ({"run" : [[firstLumi, lastLumi], ...], ...}) and compiled in one
+  // bitmap of luminosity sections per run. accept() costs a run lookup,
+  // cached for consecutive events of the same run, and a bit test.
+  // Not thread safe (run cache), every worker uses its own copy
+  class LumiMask {
+
+  public :
+
+    LumiMask() : m_lastRun(-1), m_lastLumis(0) {};
+
+    void load(const std::string & jsonFile)
+    {
+      boost::property_tree::ptree pt;
+
+      try
+	{
+	  boost::property_tree::json_parser::read_json(jsonFile, pt);
+
+	  for (auto & run : pt)
+	    {
+	      Int_t runNumber = std::stoi(run.first);
+	      std::vector<bool> & lumis = m_runs[runNumber];
+
+	      for (auto & range : run.second)
+		{
+		  std::vector<Int_t> bounds;
+		  for (auto & bound : range.second)
+		    bounds.push_back(bound.second.get_value<Int_t>());
+
+		  if (bounds.size() != 2 || bounds[0] < 0 || bounds[1] < bounds[0])
+		    throw std::runtime_error("invalid lumi range for run " + run.first);
+
+		  if (Int_t(lumis.size()) <= bounds[1])
+		    lumis.resize(bounds[1] + 1, false);
+
+		  for (Int_t iLumi = bounds[0]; iLumi <= bounds[1]; ++iLumi)
+		    lumis[iLumi] = true;
+		}
+	    }
+	}
+      catch (std::exception & exc)
+	{
+	  std::cout << "[LumiMask] Can't read lumi mask : " << jsonFile
+		    << "\n\thas error : " << exc.what() << std::endl;
+	  exit(900);
+	}
+
+      m_lastRun   = -1;
+      m_lastLumis = 0;
+
+      std::cout << "[LumiMask] Loaded " << jsonFile << " : "
+		<< m_runs.size() << " runs" << std::endl;
+    }
+
+    bool empty() const { return m_runs.empty(); };
+
+    bool accept(Int_t runNumber, Int_t lumiNumber)
+    {
+      if (runNumber != m_lastRun)
+	{
+	  std::map<Int_t, std::vector<bool> >::const_iterator runIt = m_runs.find(runNumber);
+	  m_lastRun   = runNumber;
+	  m_lastLumis = runIt != m_runs.end() ? &(runIt->second) : 0;
+	}
+
+      return m_lastLumis && lumiNumber >= 0 &&
+	     lumiNumber < Int_t(m_lastLumis->size()) && (*m_lastLumis)[lumiNumber];
+    }
+
+  private :
+
+    std::map<Int_t, std::vector<bool> > m_runs;
+
+    Int_t m_lastRun;
+    const std::vector<bool> * m_lastLumis;
+
+  };
+
+  // Entries in [firstEntry, lastEntry) of a tree (or chain) passing the
+  // mask. Only the small eventId branch is read, so the event branch of
+  // rejected entries is never deserialized and clusters without accepted
+  // entries are never read at all. The branch statuses and the read cache
+  // of the tree are reset, branches have to be selected afterwards
+  inline std::vector<Long64_t> acceptedEntries(TTree * tree,
+					       Long64_t firstEntry, Long64_t lastEntry,
+					       muon_pog::LumiMask & mask)
+  {
+    if (!tree->GetBranch("eventId"))
+      {
+	std::cout << "[acceptedEntries] No eventId branch, "
+		  << "can't apply the lumi mask" << std::endl;
+	exit(900);
+      }
+
+    tree->SetBranchStatus("*",0);
+    tree->SetBranchStatus("eventId*",1);
+
+    muon_pog::EventId * eventId = new muon_pog::EventId();
+    tree->SetBranchAddress("eventId",&eventId);
+
+    std::vector<Long64_t> entries;
+
+    for (Long64_t iEntry = firstEntry; iEntry < lastEntry; ++iEntry)
+      {
+	if (tree->GetEntry(iEntry) <= 0) break;
+
+	if (mask.accept(eventId->runNumber, eventId->luminosityBlockNumber))
+	  entries.push_back(iEntry);
+      }
+
+    tree->ResetBranchAddresses();
+    tree->SetCacheSize(0); // the cache has learnt eventId only
+    delete eventId;
+
+    std::cout << "[acceptedEntries] Lumi mask accepts " << entries.size()
+	      << " out of " << lastEntry - firstEntry << " entries" << std::endl;
+
+    return entries;
+  }
+
+}
+#endif
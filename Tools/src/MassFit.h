@@ -0,0 +1,279 @@
+#ifndef MuonPOG_Tools_MassFit_H
+#define MuonPOG_Tools_MassFit_H
+
+#include "ParallelUtils.h"
+
+#include "TF1.h"
+#include "TH1.h"
+#include "TMath.h"
+#include "TString.h"
+
+#include "Fit/BinData.h"
+#include "Fit/DataOptions.h"
+#include "Fit/DataRange.h"
+#include "Fit/FitResult.h"
+#include "Fit/Fitter.h"
+#include "HFitInterface.h"
+#include "Math/WrappedMultiTF1.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace muon_pog {
+
+  // Signal + background model of an invariant mass fit, built from the
+  // signFitFunc (Gaus, BreitWigner, Voigt, CrystalBall) and bkgFitFunc
+  // (None, Flat, Expo, Pol1, Pol2) config parameters. The signal
+  // parameters come first : normalisation, peak and resolution
+  class MassFitModel {
+
+  public :
+
+    MassFitModel() : m_nSignPars(0), m_nBkgPars(0) {};
+
+    MassFitModel(const std::string & signal, const std::string & background) :
+      m_signal(firstWord(signal)), m_background(firstWord(background))
+    {
+      if (m_signal == "Gaus")
+	{
+	  m_formula = "[0]*exp(-0.5*((x-[1])/[2])^2)";
+	  m_nSignPars = 3;
+	}
+      else if (m_signal == "BreitWigner")
+	{
+	  m_formula = "[0]*TMath::BreitWigner(x,[1],[2])";
+	  m_nSignPars = 3;
+	}
+      else if (m_signal == "Voigt")
+	{
+	  m_formula = "[0]*TMath::Voigt(x-[1],[2],[3])";
+	  m_nSignPars = 4;
+	}
+      else if (m_signal == "CrystalBall")
+	{
+	  m_formula = "[0]*ROOT::Math::crystalball_function(x,[3],[4],[2],[1])";
+	  m_nSignPars = 5;
+	}
+      else
+	{
+	  std::cout << "[MassFitModel]: Invalid signal function : " << m_signal
+		    << " (Gaus, BreitWigner, Voigt, CrystalBall)" << std::endl;
+	  exit(900);
+	}
+
+      Int_t iPar = m_nSignPars;
+
+      if (m_background == "None")
+	m_nBkgPars = 0;
+      else if (m_background == "Flat")
+	{
+	  m_formula += TString::Format("+[%d]",iPar);
+	  m_nBkgPars = 1;
+	}
+      else if (m_background == "Expo")
+	{
+	  m_formula += TString::Format("+exp([%d]+[%d]*x)",iPar,iPar+1);
+	  m_nBkgPars = 2;
+	}
+      else if (m_background == "Pol1")
+	{
+	  m_formula += TString::Format("+[%d]+[%d]*x",iPar,iPar+1);
+	  m_nBkgPars = 2;
+	}
+      else if (m_background == "Pol2")
+	{
+	  m_formula += TString::Format("+[%d]+[%d]*x+[%d]*x*x",iPar,iPar+1,iPar+2);
+	  m_nBkgPars = 3;
+	}
+      else
+	{
+	  std::cout << "[MassFitModel]: Invalid background function : " << m_background
+		    << " (None, Flat, Expo, Pol1, Pol2)" << std::endl;
+	  exit(900);
+	}
+    }
+
+    const std::string & signal() const { return m_signal; };
+    const std::string & background() const { return m_background; };
+
+    Int_t peakPar() const { return 1; };
+    Int_t resolutionPar() const { return 2; };
+
+    // Model function over [min, max] with starting values taken from the plot,
+    // to be created from the main thread (TF1 registers itself in gROOT)
+    TF1 * function(const TString & name, const TH1 & plot) const
+    {
+      Double_t min = plot.GetXaxis()->GetXmin();
+      Double_t max = plot.GetXaxis()->GetXmax();
+
+      TF1 * func = new TF1(name, m_formula, min, max);
+
+      Int_t maxBin = std::max(1,plot.GetMaximumBin());
+      Double_t peak  = plot.GetBinCenter(maxBin);
+      Double_t sigma = std::max(plot.GetRMS() / 2., 2. * plot.GetBinWidth(1));
+
+      Int_t nBins = plot.GetNbinsX();
+      Double_t bkg = std::max(0., .5 * (plot.GetBinContent(1) + plot.GetBinContent(nBins)));
+      Double_t height = std::max(1., plot.GetBinContent(maxBin) - bkg);
+
+      // normalised line shapes have height ~ norm / width
+      Double_t norm = height;
+      if (m_signal == "BreitWigner")
+	norm = height * TMath::Pi() * sigma / 2.;
+      else if (m_signal == "Voigt")
+	norm = height * sigma * std::sqrt(TMath::TwoPi());
+
+      func->SetParameter(0, norm);
+      func->SetParLimits(0, 0., 100. * norm);
+      func->SetParameter(1, peak);
+      func->SetParLimits(1, min, max);
+      func->SetParameter(2, sigma);
+      func->SetParLimits(2, 1.e-3 * (max - min), max - min);
+
+      if (m_signal == "Voigt")
+	{
+	  func->SetParameter(3, sigma);
+	  func->SetParLimits(3, 0., max - min);
+	}
+      else if (m_signal == "CrystalBall")
+	{
+	  func->SetParameter(3, 1.5);
+	  func->SetParLimits(3, .1, 10.);
+	  func->SetParameter(4, 2.);
+	  func->SetParLimits(4, 1.01, 50.);
+	}
+
+      Int_t iPar = m_nSignPars;
+
+      if (m_background == "Expo")
+	{
+	  func->SetParameter(iPar, std::log(std::max(1., bkg)));
+	  func->SetParameter(iPar + 1, 0.);
+	}
+      else if (m_nBkgPars > 0)
+	{
+	  func->SetParameter(iPar, bkg);
+	  for (Int_t iBkgPar = 1; iBkgPar < m_nBkgPars; ++iBkgPar)
+	    func->SetParameter(iPar + iBkgPar, 0.);
+	}
+
+      return func;
+    }
+
+  private :
+
+    // Config values can carry trailing comments (e.g. "Gaus # dummy")
+    static std::string firstWord(const std::string & value)
+    {
+      std::string::size_type begin = value.find_first_not_of(" \t");
+      if (begin == std::string::npos) return "";
+      std::string::size_type end = value.find_first_of(" \t#;", begin);
+      return value.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    }
+
+    std::string m_signal;
+    std::string m_background;
+
+    TString m_formula;
+    Int_t m_nSignPars;
+    Int_t m_nBkgPars;
+
+  };
+
+  // One binned fit of an invariant mass plot and its results
+  class MassFit {
+
+  public :
+
+    TString config; // plotter title
+    TString bin;    // plot key
+    std::string signal;
+    std::string background;
+
+    TH1 * plot;
+    TF1 * func;
+
+    Int_t peakPar;
+    Int_t resolutionPar;
+
+    Int_t    status; // minimizer status, -1 if the fit was not run
+    Double_t chi2;
+    Int_t    ndf;
+    std::vector<Double_t> pars;
+    std::vector<Double_t> parErrors;
+
+    Double_t peak;
+    Double_t peakError;
+    Double_t resolution;
+    Double_t resolutionError;
+
+    MassFit() : plot(0), func(0), peakPar(1), resolutionPar(2),
+		status(-1), chi2(0.), ndf(0), peak(0.), peakError(0.),
+		resolution(0.), resolutionError(0.) {};
+
+    // Chi2 fit with Minuit2 on the non-empty bins. Only objects owned by
+    // this fit are used, so that different fits can run concurrently
+    void run()
+    {
+      if (!plot || !func || plot->GetEntries() < func->GetNpar())
+	return;
+
+      ROOT::Fit::DataOptions options;
+      ROOT::Fit::DataRange range(plot->GetXaxis()->GetXmin(), plot->GetXaxis()->GetXmax());
+      ROOT::Fit::BinData data(options, range);
+      ROOT::Fit::FillData(data, plot);
+
+      ROOT::Math::WrappedMultiTF1 model(*func, 1);
+
+      ROOT::Fit::Fitter fitter;
+      fitter.SetFunction(model, false);
+      fitter.Config().SetMinimizer("Minuit2","Migrad");
+
+      for (Int_t iPar = 0; iPar < func->GetNpar(); ++iPar)
+	{
+	  Double_t low, high;
+	  func->GetParLimits(iPar, low, high);
+	  if (low < high)
+	    fitter.Config().ParSettings(iPar).SetLimits(low, high);
+	}
+
+      fitter.Fit(data);
+
+      const ROOT::Fit::FitResult & result = fitter.Result();
+
+      status    = result.Status();
+      chi2      = result.Chi2();
+      ndf       = result.Ndf();
+      pars      = result.Parameters();
+      parErrors = result.Errors();
+
+      if (pars.empty()) return;
+
+      func->SetParameters(&pars[0]);
+      func->SetParErrors(&parErrors[0]);
+      func->SetChisquare(chi2);
+      func->SetNDF(ndf);
+
+      peak            = pars[peakPar];
+      peakError       = parErrors[peakPar];
+      resolution      = std::fabs(pars[resolutionPar]);
+      resolutionError = parErrors[resolutionPar];
+    }
+
+  };
+
+  // Run independent fits on a pool of nThreads threads
+  inline void runFits(std::vector<muon_pog::MassFit> & fits, unsigned int nThreads)
+  {
+    muon_pog::parallelFor(fits.size(), nThreads, [&](unsigned int iFit)
+			  {
+			    fits[iFit].run();
+			  });
+  }
+
+}
+#endif
@@ -0,0 +1,166 @@
+#ifndef MuonPOG_Tools_MuonPogColumns_H
+#define MuonPOG_Tools_MuonPogColumns_H
+
+#include "MuonPogTree.h"
+
+#include "TTree.h"
+
+#include <set>
+#include <string>
+
+// Columnar (structure of arrays) layout of the muon collection :
+// one flat branch per muon_pog::Muon member, named muons_<member>
+// and sized by the nMuons branch (e.g. muons_pt_tuneP[nMuons]/F).
+// Readers only pay for the columns they set an address to.
+
+// List of the columns : X(type, leaf type code, muon_pog::Muon member)
+#define MUON_POG_MUON_COLUMNS(X)			\
+  X(Float_t, F, pt)					\
+  X(Float_t, F, eta)					\
+  X(Float_t, F, phi)					\
+  X(Int_t,   I, charge)					\
+  X(Float_t, F, pt_tuneP)				\
+  X(Float_t, F, eta_tuneP)				\
+  X(Float_t, F, phi_tuneP)				\
+  X(Int_t,   I, charge_tuneP)				\
+  X(Float_t, F, pt_global)				\
+  X(Float_t, F, eta_global)				\
+  X(Float_t, F, phi_global)				\
+  X(Int_t,   I, charge_global)				\
+  X(Float_t, F, pt_tracker)				\
+  X(Float_t, F, eta_tracker)				\
+  X(Float_t, F, phi_tracker)				\
+  X(Int_t,   I, charge_tracker)			\
+  X(Int_t,   I, isGlobal)				\
+  X(Int_t,   I, isTracker)				\
+  X(Int_t,   I, isTrackerArb)				\
+  X(Int_t,   I, isRPC)					\
+  X(Int_t,   I, isStandAlone)				\
+  X(Int_t,   I, isPF)					\
+  X(Int_t,   I, isSoft)					\
+  X(Int_t,   I, isLoose)				\
+  X(Int_t,   I, isTight)				\
+  X(Int_t,   I, isMedium)				\
+  X(Int_t,   I, isHighPt)				\
+  X(Float_t, F, chargedHadronIso)			\
+  X(Float_t, F, chargedHadronIsoPU)			\
+  X(Float_t, F, photonIso)				\
+  X(Float_t, F, neutralHadronIso)			\
+  X(Float_t, F, isoPflow04)				\
+  X(Float_t, F, isoPflow03)				\
+  X(Float_t, F, dxy)					\
+  X(Float_t, F, dz)					\
+  X(Float_t, F, edxy)					\
+  X(Float_t, F, edz)					\
+  X(Float_t, F, dxybs)					\
+  X(Float_t, F, dzbs)					\
+  X(Int_t,   I, nHitsGlobal)				\
+  X(Int_t,   I, nHitsTracker)				\
+  X(Int_t,   I, nHitsStandAlone)			\
+  X(Float_t, F, glbNormChi2)				\
+  X(Float_t, F, trkNormChi2)				\
+  X(Int_t,   I, trkMuonMatchedStations)			\
+  X(Int_t,   I, glbMuonValidHits)			\
+  X(Int_t,   I, trkPixelValidHits)			\
+  X(Int_t,   I, trkPixelLayersWithMeas)			\
+  X(Int_t,   I, trkTrackerLayersWithMeas)		\
+  X(Float_t, F, bestMuPtErr)				\
+  X(Float_t, F, trkValidHitFrac)			\
+  X(Float_t, F, trkStaChi2)				\
+  X(Float_t, F, trkKink)				\
+  X(Float_t, F, muSegmComp)				\
+  X(Int_t,   I, isTrkMuOST)				\
+  X(Int_t,   I, isTrkHP)				\
+  X(Float_t, F, dxyBest)				\
+  X(Float_t, F, dzBest)					\
+  X(Float_t, F, dxyInner)				\
+  X(Float_t, F, dzInner)				\
+  X(Float_t, F, muonTimeDof)				\
+  X(Float_t, F, muonTime)				\
+  X(Float_t, F, muonTimeErr)				\
+  X(Int_t,   I, genIndex)				\
+  X(Float_t, F, genDr)
+
+namespace muon_pog {
+
+  class MuonView;
+
+  class MuonColumns {
+  public:
+
+    static const Int_t kMaxMuons = 100; // muons beyond this are not stored
+
+    Int_t nMuons; // number of muons in the event
+
+#define MUON_POG_DECLARE_COLUMN(TYPE, LEAF, NAME) TYPE NAME[kMaxMuons];
+    MUON_POG_MUON_COLUMNS(MUON_POG_DECLARE_COLUMN)
+#undef MUON_POG_DECLARE_COLUMN
+
+    MuonColumns() : nMuons(0) {};
+
+    void clear() { nMuons = 0; };
+
+    // Append a muon, returns false if the columns are already full
+    bool push_back(const muon_pog::Muon & muon) {
+      if ( nMuons >= kMaxMuons ) return false;
+#define MUON_POG_COPY_COLUMN(TYPE, LEAF, NAME) NAME[nMuons] = muon.NAME;
+      MUON_POG_MUON_COLUMNS(MUON_POG_COPY_COLUMN)
+#undef MUON_POG_COPY_COLUMN
+      ++nMuons;
+      return true;
+    }
+
+    // Create nMuons and one muons_<member> branch per column
+    void branch(TTree * tree) {
+      tree->Branch("nMuons", &nMuons, "nMuons/I");
+#define MUON_POG_BRANCH_COLUMN(TYPE, LEAF, NAME)			\
+      tree->Branch("muons_" #NAME, NAME, "muons_" #NAME "[nMuons]/" #LEAF);
+      MUON_POG_MUON_COLUMNS(MUON_POG_BRANCH_COLUMN)
+#undef MUON_POG_BRANCH_COLUMN
+    }
+
+    // Read nMuons and the columns of the given muon_pog::Muon members
+    // (e.g. "pt_tuneP", "isTight"), all of them if members is empty
+    void setBranchAddresses(TTree * tree, const std::set<std::string> & members = std::set<std::string>()) {
+      tree->SetBranchAddress("nMuons", &nMuons);
+#define MUON_POG_ADDRESS_COLUMN(TYPE, LEAF, NAME)			\
+      if ( members.empty() || members.count(#NAME) )			\
+	tree->SetBranchAddress("muons_" #NAME, NAME);
+      MUON_POG_MUON_COLUMNS(MUON_POG_ADDRESS_COLUMN)
+#undef MUON_POG_ADDRESS_COLUMN
+    }
+
+    Int_t size() const { return nMuons; };
+
+    muon_pog::MuonView at(Int_t iMuon) const;
+
+  };
+
+  // Non-virtual accessor to one muon of the columns, member
+  // functions are named as the muon_pog::Muon data members
+  class MuonView {
+  public:
+
+    MuonView(const muon_pog::MuonColumns & columns, Int_t iMuon) :
+      m_columns(&columns), m_iMuon(iMuon) {};
+
+    Int_t index() const { return m_iMuon; };
+
+#define MUON_POG_VIEW_COLUMN(TYPE, LEAF, NAME)			\
+    TYPE NAME() const { return m_columns->NAME[m_iMuon]; };
+    MUON_POG_MUON_COLUMNS(MUON_POG_VIEW_COLUMN)
+#undef MUON_POG_VIEW_COLUMN
+
+  private:
+
+    const muon_pog::MuonColumns * m_columns;
+    Int_t m_iMuon;
+
+  };
+
+  inline muon_pog::MuonView MuonColumns::at(Int_t iMuon) const {
+    return muon_pog::MuonView(*this, iMuon);
+  }
+
+}
+#endif
@@ -3,6 +3,8 @@
 
 #include "TROOT.h"
 #include "TMath.h"
+#include <algorithm>
+#include <map>
 #include <vector>
 #include <string>
 
@@ -31,12 +33,16 @@ namespace muon_pog {
     Float_t vx; // x coordinate of production vertex [cm]
     Float_t vy;// y coordinate of production vertex [cm]
     Float_t vz;// z coordinate of production vertex [cm]
-    std::vector<Int_t> mothers; // vector of indices of mothers
+    std::vector<Int_t> mothers; // vector of pdgIds of mothers
+    std::vector<Int_t> motherIndices; // vector of indices of mothers in genParticles (-1 if not stored)
 
-    GenParticle(){};
+    Int_t   muonIndex; // index in muons of the closest muon in dR (status 1 muons only, -1 if none)
+    Float_t muonDr;    // dR to that muon (-999 if none)
+
+    GenParticle() : muonIndex(-1), muonDr(-999.) {};
     virtual ~GenParticle(){};
     
-    ClassDef(GenParticle,1)
+    ClassDef(GenParticle,2)
   };
 
   class METs {
@@ -144,49 +150,117 @@ namespace muon_pog {
     Float_t muonTime; 
     Float_t muonTimeErr; 
 
-    Muon(){};
+    // Gen matching
+    Int_t   genIndex; // index in genParticles of the closest status 1 muon in dR (-1 if none)
+    Float_t genDr;    // dR to that gen muon (-999 if none)
+
+    Muon() : genIndex(-1), genDr(-999.) {};
     virtual ~Muon(){};
 
-    ClassDef(Muon,1)
+    ClassDef(Muon,2)
+  };
+
+  class HLTNames {
+  public:
+
+    Int_t runNumber;                  // run number
+    std::string processName;          // process name of the HLT menu
+    std::vector<std::string> paths;   // HLT paths of the menu, the index is the bit used in HLT::pathBits
+    std::vector<std::string> filters; // filters of the menu (label::process), the index is HLTObject::filterId
+
+    HLTNames() : runNumber(-1) {};
+    virtual ~HLTNames(){};
+
+    // Indices of the paths equal to (exact) or containing (!exact) a given name,
+    // every name is resolved once and then kept in a per-run cache
+    const std::vector<UInt_t> & pathIds( const std::string & name, bool exact ) const {
+      std::map<std::string, std::vector<UInt_t> > & cache = exact ? exactPathIds : foundPathIds;
+      std::map<std::string, std::vector<UInt_t> >::const_iterator cacheIt = cache.find(name);
+      if ( cacheIt != cache.end() ) return cacheIt->second;
+
+      std::vector<UInt_t> & ids = cache[name];
+      for ( UInt_t iPath = 0; iPath < paths.size(); ++iPath ) {
+	if ( exact ? paths[iPath] == name : paths[iPath].find(name) != std::string::npos )
+	  ids.push_back(iPath);
+      }
+      return ids;
+    }
+
+    mutable std::map<std::string, std::vector<UInt_t> > exactPathIds; //! resolved by pathIds()
+    mutable std::map<std::string, std::vector<UInt_t> > foundPathIds; //! resolved by pathIds()
+
+    ClassDef(HLTNames,1)
+
   };
 
   class HLTObject {
   public:
 
-    std::string filterTag; // name of filter passed by the object
+    Int_t filterId;        // index of the filter in HLTNames::filters, -1 if not in the menu
+    std::string filterTag; // name of filter passed by the object, only set if filterId is -1
     Float_t pt;            // pt of the object passing the filter [GeV]
     Float_t eta;           // eta of the object passing the filter
     Float_t phi;           // phi of the object passing the filter
     
-    HLTObject(){};
+    HLTObject() : filterId(-1) {};
     virtual ~HLTObject(){};
 
-    ClassDef(HLTObject,1)
+    ClassDef(HLTObject,2)
 
   };
 
   class HLT {
   public:
-    std::vector<std::string> triggers; // vector of strings with HLT paths
+    std::vector<std::string> triggers; // vector of strings with HLT paths, only filled when no HLTNames are available
+    std::vector<UInt_t> pathBits;      // bit i is set if HLTNames::paths[i] has fired
     std::vector<muon_pog::HLTObject>   objects;  // vector of hlt objects assing filters
 
-    HLT(){};
+    const muon_pog::HLTNames * names; //! path and filter names of the run, to be set by the reader
+
+    HLT() : names(0) {};
     virtual ~HLT(){};
-    bool match( const std::string & path ) {
+
+    bool hasFired( UInt_t pathId ) const {
+      UInt_t word = pathId / 32;
+      return word < pathBits.size() && ( pathBits[word] >> (pathId % 32) ) & 1;
+    }
+
+    bool match( const std::string & path ) const {
+      if ( names && triggers.empty() ) {
+	for ( UInt_t pathId : names->pathIds(path,true) ) {
+	  if ( hasFired(pathId) ) return true;
+	}
+	return false;
+      }
+
       if (  std::find (  triggers.begin(), triggers.end(), path ) != triggers.end() )
 	return true;
       
       return false;
     }
 
-    bool find( const std::string & path ) {
+    bool find( const std::string & path ) const {
+      if ( names && triggers.empty() ) {
+	for ( UInt_t pathId : names->pathIds(path,false) ) {
+	  if ( hasFired(pathId) ) return true;
+	}
+	return false;
+      }
+
       for ( std::vector<std::string>::const_iterator it = triggers.begin(); it != triggers.end(); ++it ) {
 	if ( it->find ( path ) != std::string::npos ) return true;
       }
       return false;
     }
 
-    ClassDef(HLT,1)
+    // Name of the filter passed by an object, from the run names when available
+    const std::string & filterTag( const muon_pog::HLTObject & object ) const {
+      if ( names && object.filterId >= 0 && object.filterId < Int_t(names->filters.size()) )
+	return names->filters[object.filterId];
+      return object.filterTag;
+    }
+
+    ClassDef(HLT,2)
 
   };
 
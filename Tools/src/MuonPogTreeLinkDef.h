@@ -11,6 +11,7 @@
 #pragma link C++ class muon_pog::Muon+;
 #pragma link C++ class muon_pog::HLT+;
 #pragma link C++ class muon_pog::HLTObject+;
+#pragma link C++ class muon_pog::HLTNames+;
 #pragma link C++ class std::vector<muon_pog::GenInfo>+;
 #pragma link C++ class std::vector<muon_pog::GenParticle>+;
 #pragma link C++ class std::vector<muon_pog::Muon>+;
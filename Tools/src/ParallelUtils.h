@@ -0,0 +1,67 @@
+#ifndef MuonPOG_Tools_ParallelUtils_H
+#define MuonPOG_Tools_ParallelUtils_H
+
+#include "Rtypes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace muon_pog {
+
+  // Split [0,nEntries) in nChunks contiguous entry ranges [first,last),
+  // keeping the original entry ordering across chunks
+  inline std::vector<std::pair<Long64_t,Long64_t> > splitEntries(Long64_t nEntries,
+								 unsigned int nChunks)
+  {
+    std::vector<std::pair<Long64_t,Long64_t> > chunks;
+
+    if (nChunks < 1) nChunks = 1;
+    Long64_t chunkSize = nEntries / nChunks;
+    Long64_t remainder = nEntries % nChunks;
+
+    Long64_t first = 0;
+    for (unsigned int iChunk = 0; iChunk < nChunks; ++iChunk)
+      {
+	Long64_t last = first + chunkSize + (Long64_t(iChunk) < remainder ? 1 : 0);
+	if (last > first)
+	  chunks.push_back(std::make_pair(first,last));
+	first = last;
+      }
+
+    return chunks;
+  }
+
+  // Run task(iTask) for every iTask in [0,nTasks) using up to nThreads
+  // worker threads, tasks are handed out dynamically to balance the load.
+  // With nThreads <= 1 everything runs in the calling thread
+  template<class Task>
+  void parallelFor(unsigned int nTasks, unsigned int nThreads, Task task)
+  {
+    if (nThreads <= 1 || nTasks <= 1)
+      {
+	for (unsigned int iTask = 0; iTask < nTasks; ++iTask)
+	  task(iTask);
+	return;
+      }
+
+    std::atomic<unsigned int> nextTask(0);
+
+    auto worker = [&]()
+      {
+	for (unsigned int iTask = nextTask++; iTask < nTasks; iTask = nextTask++)
+	  task(iTask);
+      };
+
+    std::vector<std::thread> workers;
+    for (unsigned int iThread = 0; iThread < std::min(nThreads,nTasks); ++iThread)
+      workers.push_back(std::thread(worker));
+
+    for (auto & thread : workers)
+      thread.join();
+  }
+
+}
+#endif
@@ -0,0 +1,155 @@
+#ifndef MuonPOG_Tools_PileupReweighting_H
+#define MuonPOG_Tools_PileupReweighting_H
+
+#include "MuonPogTree.h"
+#include "ReaderUtils.h"
+
+#include "TChain.h"
+#include "TFile.h"
+#include "TH1.h"
+#include "TString.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace muon_pog {
+
+  // Data pileup profile, detached from its file
+  inline TH1 * loadPileupProfile(const std::string & fileName, const std::string & histoName)
+  {
+    TFile * file = TFile::Open(fileName.c_str(),"READONLY");
+    TH1 * profile = 0;
+    if (file) file->GetObject(histoName.c_str(),profile);
+
+    if (!profile)
+      {
+	std::cout << "[loadPileupProfile] Can't get histogram " << histoName
+		  << " from " << fileName << std::endl;
+	exit(900);
+      }
+
+    profile = static_cast<TH1 *>(profile->Clone("dataPileupProfile"));
+    profile->SetDirectory(0);
+
+    file->Close();
+    delete file;
+
+    return profile;
+  }
+
+  // genInfos[0].trueNumberOfInteractions distribution of a set of
+  // MC files, with the binning of a reference profile and the sign of
+  // the generator weight, reading the genInfos branch only
+  inline TH1 * mcPileupProfile(const std::vector<TString> & fileNames, const TH1 & binning)
+  {
+    TH1 * profile = static_cast<TH1 *>(binning.Clone("mcPileupProfile"));
+    profile->Reset();
+    profile->SetDirectory(0);
+
+    TChain * chain = muon_pog::openChain(fileNames);
+
+    std::set<std::string> branches;
+    branches.insert("genInfos");
+    branches.insert("genInfos.trueNumberOfInteractions");
+    branches.insert("genInfos.genWeight");
+    muon_pog::selectBranches(chain,branches);
+
+    muon_pog::Event * ev = new muon_pog::Event();
+    chain->SetBranchAddress("event",&ev);
+
+    Long64_t nEntries = chain->GetEntries();
+    for (Long64_t iEntry = 0; iEntry < nEntries; ++iEntry)
+      {
+	if (chain->GetEntry(iEntry) <= 0) break;
+	if (ev->genInfos.empty()) continue;
+
+	const muon_pog::GenInfo & genInfo = ev->genInfos[0];
+	profile->Fill(genInfo.trueNumberOfInteractions,
+		      genInfo.genWeight < 0. ? -1. : 1.);
+      }
+
+    delete chain;
+    delete ev;
+
+    std::cout << "[mcPileupProfile] Pileup profile from " << nEntries
+	      << " MC events" << std::endl;
+
+    return profile;
+  }
+
+  // Pileup weights of an MC sample : ratio of the normalised data pileup
+  // profile (e.g. the "pileup" histogram from pileupCalc.py) and of the
+  // genInfos[0].trueNumberOfInteractions distribution of the sample.
+  // Weights are computed once, with the data profile binning, and stored
+  // in a table, weight() is one array lookup
+  class PileupReweighting {
+
+  public :
+
+    PileupReweighting() : m_min(0.), m_binWidth(1.) {};
+
+    // Data profile from histoName in dataFile, MC profile from mcFiles
+    void load(const std::string & dataFile, const std::string & histoName,
+	      const std::vector<TString> & mcFiles)
+    {
+      TH1 * dataProfile = muon_pog::loadPileupProfile(dataFile, histoName);
+      TH1 * mcProfile   = muon_pog::mcPileupProfile(mcFiles, *dataProfile);
+
+      compute(*dataProfile, *mcProfile);
+
+      delete dataProfile;
+      delete mcProfile;
+    }
+
+    // Weights from two profiles with the same (uniform) binning
+    void compute(const TH1 & dataProfile, const TH1 & mcProfile)
+    {
+      Int_t nBins = dataProfile.GetNbinsX();
+
+      m_min      = dataProfile.GetXaxis()->GetXmin();
+      m_binWidth = (dataProfile.GetXaxis()->GetXmax() - m_min) / nBins;
+
+      Double_t dataIntegral = dataProfile.Integral();
+      Double_t mcIntegral   = mcProfile.Integral();
+
+      m_weights.assign(nBins, 0.);
+
+      if (dataIntegral <= 0. || mcIntegral <= 0.)
+	{
+	  std::cout << "[PileupReweighting] Empty pileup profile, "
+		    << "all weights are 0" << std::endl;
+	  return;
+	}
+
+      for (Int_t iBin = 0; iBin < nBins; ++iBin)
+	{
+	  Double_t mc = mcProfile.GetBinContent(iBin + 1) / mcIntegral;
+	  if (mc > 0.)
+	    m_weights[iBin] = dataProfile.GetBinContent(iBin + 1) / dataIntegral / mc;
+	}
+    }
+
+    bool empty() const { return m_weights.empty(); };
+    const std::vector<Float_t> & weights() const { return m_weights; };
+
+    // Weight for a given true number of interactions, 0 out of the profile range
+    Float_t weight(Float_t trueNumberOfInteractions) const
+    {
+      Int_t iBin = Int_t(std::floor((trueNumberOfInteractions - m_min) / m_binWidth));
+      return iBin >= 0 && iBin < Int_t(m_weights.size()) ? m_weights[iBin] : 0.;
+    }
+
+  private :
+
+    Double_t m_min;
+    Double_t m_binWidth;
+    std::vector<Float_t> m_weights;
+
+  };
+
+}
+#endif
@@ -0,0 +1,237 @@
+#ifndef MuonPOG_Tools_ReaderUtils_H
+#define MuonPOG_Tools_ReaderUtils_H
+
+#include "MuonPogTree.h"
+
+#include "TFile.h"
+#include "TH1.h"
+#include "TChain.h"
+#include "TString.h"
+#include "TTree.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace muon_pog {
+
+  // Path of the ntuple tree inside a file : either at top level
+  // or inside the TFileService directory of the producer
+  inline TString treePath(const TString & fileName)
+  {
+    TString path = "MUONPOGTREE";
+
+    TFile * file = TFile::Open(fileName,"READONLY");
+    if (file && !file->Get(path))
+      path = "MuonPogTree/MUONPOGTREE";
+
+    if (file)
+      {
+	file->Close();
+	delete file;
+      }
+
+    return path;
+  }
+
+  // Sum of the generator weight signs of all the events processed by
+  // the producer, before its preselection ("processed gen weights" bin
+  // of the skimCounters histogram stored next to the tree). Returns
+  // false if a file was written before that bin existed and has events
+  // rejected by the preselection, true and 0 if no file has skimCounters
+  // (nothing was rejected, the sum of the stored events has to be used)
+  inline bool processedGenWeights(const std::vector<TString> & fileNames,
+				  Double_t & sumGenWeights, bool & hasCounters)
+  {
+    sumGenWeights = 0.;
+    hasCounters = true;
+    bool allCounters = true;
+
+    for (auto & fileName : fileNames)
+      {
+	TString countersPath = treePath(fileName);
+	countersPath.ReplaceAll("MUONPOGTREE","skimCounters");
+
+	TFile * file = TFile::Open(fileName,"READONLY");
+	if (!file)
+	  {
+	    std::cout << "[processedGenWeights]: Can't open " << fileName << std::endl;
+	    exit(900);
+	  }
+
+	TH1 * counters = 0;
+	file->GetObject(countersPath,counters);
+
+	if (!counters)
+	  allCounters = false;
+	else
+	  {
+	    Int_t processedBin = -1;
+	    Int_t acceptedBin  = -1;
+	    Int_t weightsBin   = -1;
+
+	    for (Int_t iBin = 1; iBin <= counters->GetNbinsX(); ++iBin)
+	      {
+		TString label = counters->GetXaxis()->GetBinLabel(iBin);
+		if (label == "processed")             processedBin = iBin;
+		if (label == "accepted")              acceptedBin  = iBin;
+		if (label == "processed gen weights") weightsBin   = iBin;
+	      }
+
+	    if (weightsBin > 0)
+	      sumGenWeights += counters->GetBinContent(weightsBin);
+	    else if (processedBin > 0 && acceptedBin > 0 &&
+		     counters->GetBinContent(processedBin) > counters->GetBinContent(acceptedBin))
+	      {
+		file->Close();
+		delete file;
+		return false;
+	      }
+	    else
+	      allCounters = false;
+	  }
+
+	file->Close();
+	delete file;
+      }
+
+    hasCounters = allCounters;
+    if (!hasCounters) sumGenWeights = 0.;
+
+    return true;
+  }
+
+  // Expand a comma separated list of input files, every entry can
+  // contain wildcards in the file name (e.g. /path/ntuples_*.root)
+  inline std::vector<TString> expandFileNames(const TString & fileList)
+  {
+    std::vector<TString> fileNames;
+
+    std::stringstream entries(fileList.Data());
+    std::string entry;
+    while (std::getline(entries, entry, ','))
+      {
+	TString pattern = TString(entry).Strip(TString::kBoth);
+	if (pattern.IsNull()) continue;
+
+	TChain chain("MUONPOGTREE");
+	chain.Add(pattern);
+
+	TIter next(chain.GetListOfFiles());
+	while (TObject * element = next())
+	  fileNames.push_back(element->GetTitle()); // TChainElement title is the file name
+      }
+
+    return fileNames;
+  }
+
+  // Build a chain over a set of ntuple files, the tree path is taken
+  // from the first file of the list
+  inline TChain * openChain(const std::vector<TString> & fileNames)
+  {
+    TChain * chain = new TChain(fileNames.empty() ? TString("MUONPOGTREE") :
+				treePath(fileNames.at(0)));
+
+    for (auto & fileName : fileNames)
+      chain->Add(fileName);
+
+    return chain;
+  }
+
+  // Per-run HLT path and filter names, read from the MUONPOGRUNS tree
+  // stored next to MUONPOGTREE. The reader sets HLT::names for every
+  // event, so that HLT::match()/find() resolve every name once per run.
+  // For ntuples written before the run tree existed nothing is loaded
+  // and HLT falls back to the path names stored in the event.
+  class HLTNamesTable {
+
+  public :
+
+    HLTNamesTable() : m_lastRun(-1), m_lastNames(0) {};
+
+    void load(const std::vector<TString> & fileNames)
+    {
+      for (auto & fileName : fileNames)
+	{
+	  TFile * file = TFile::Open(fileName,"READONLY");
+	  if (!file) continue;
+
+	  TTree * tree = 0;
+	  file->GetObject("MUONPOGRUNS",tree);
+	  if (!tree) file->GetObject("MuonPogTree/MUONPOGRUNS",tree);
+
+	  if (tree)
+	    {
+	      muon_pog::HLTNames * names = new muon_pog::HLTNames();
+	      tree->SetBranchAddress("hltNames",&names);
+
+	      for (Long64_t iEntry = 0; iEntry < tree->GetEntries(); ++iEntry)
+		{
+		  tree->GetEntry(iEntry);
+		  // the menu is the same for all the jobs processing a run
+		  if (m_runs.find(names->runNumber) == m_runs.end())
+		    m_runs[names->runNumber] = *names;
+		}
+
+	      tree->ResetBranchAddresses();
+	      delete names;
+	    }
+
+	  file->Close();
+	  delete file;
+	}
+
+      std::cout << "[HLTNamesTable] Loaded HLT names for "
+		<< m_runs.size() << " runs" << std::endl;
+    }
+
+    // Names for a given run, 0 if they were not found
+    const muon_pog::HLTNames * find(Int_t runNumber)
+    {
+      if (runNumber != m_lastRun)
+	{
+	  std::map<Int_t, muon_pog::HLTNames>::const_iterator runIt = m_runs.find(runNumber);
+	  m_lastRun   = runNumber;
+	  m_lastNames = runIt != m_runs.end() ? &(runIt->second) : 0;
+	}
+
+      return m_lastNames;
+    }
+
+    // Set the names for the run of an event
+    void setNames(muon_pog::Event & ev) { ev.hlt.names = find(ev.runNumber); };
+
+  private :
+
+    std::map<Int_t, muon_pog::HLTNames> m_runs;
+
+    Int_t m_lastRun;
+    const muon_pog::HLTNames * m_lastNames;
+
+  };
+
+  // Disable all branches but the requested ones, names are the ones of the
+  // sub-branches of the split event branch (e.g. "muons.pt_tuneP"); for
+  // collections the size branch itself (e.g. "muons") has to be requested too
+  inline void selectBranches(TTree * tree, const std::set<std::string> & branches)
+  {
+    tree->SetBranchStatus("*",0);
+
+    for (auto & branch : branches)
+      tree->SetBranchStatus(("*" + branch).c_str(),1);
+  }
+
+  // Enable a TTreeCache of cacheSize bytes, the branches to be cached
+  // are learnt from the ones read in the first learnEntries entries
+  inline void setupReadCache(TTree * tree, Long64_t cacheSize, Int_t learnEntries = 100)
+  {
+    tree->SetCacheSize(cacheSize);
+    tree->SetCacheLearnEntries(learnEntries);
+  }
+
+}
+#endif
@@ -0,0 +1,64 @@
+#ifndef MuonPOG_Tools_ResultCache_H
+#define MuonPOG_Tools_ResultCache_H
+
+#include "TFile.h"
+#include "TMD5.h"
+#include "TString.h"
+#include "TUUID.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+// Helpers to cache per input file results across jobs : cached results
+// are looked up by a key made of the identity of the input file (its
+// UUID, which changes whenever the file is rewritten, and its size)
+// and of a digest of everything else the results depend on (config
+// files, sample settings ...). Stale entries are never overwritten,
+// they are just not looked up anymore and can be removed by hand.
+
+namespace muon_pog {
+
+  // MD5 digest of a string, as 32 hex digits
+  inline TString digest(const std::string & content)
+  {
+    TMD5 md5;
+    md5.Update(reinterpret_cast<const UChar_t *>(content.data()), content.size());
+    md5.Final();
+    return md5.AsString();
+  }
+
+  // MD5 digest of the content of a (config) file, empty if it can't be read
+  inline TString fileDigest(const std::string & fileName)
+  {
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    if (!file) return "";
+
+    std::string content((std::istreambuf_iterator<char>(file)),
+			std::istreambuf_iterator<char>());
+    return muon_pog::digest(content);
+  }
+
+  // Cache key of the results of one input file, empty if it can't be opened
+  inline TString cacheKey(const TString & inputFile, const TString & configDigest)
+  {
+    TFile * file = TFile::Open(inputFile,"READONLY");
+    if (!file) return "";
+
+    std::string identity = std::string(inputFile.Data()) + "|" +
+                           file->GetUUID().AsString() + "|" +
+                           std::to_string(file->GetSize()) + "|" +
+                           configDigest.Data();
+    file->Close();
+    delete file;
+
+    return muon_pog::digest(identity);
+  }
+
+  inline bool cacheExists(const TString & cacheFile)
+  {
+    return bool(std::ifstream(cacheFile.Data()));
+  }
+
+}
+#endif
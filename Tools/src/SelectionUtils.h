@@ -0,0 +1,128 @@
+#ifndef MuonPOG_Tools_SelectionUtils_H
+#define MuonPOG_Tools_SelectionUtils_H
+
+#include "MuonPogTree.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace muon_pog {
+
+  // Pointers to the muon_pog::Muon members used by a selection, resolved
+  // once from the config strings so that the event loop does no string work
+
+  typedef Int_t   muon_pog::Muon::* MuonIntMember;
+  typedef Float_t muon_pog::Muon::* MuonFloatMember;
+
+  class TrackMembers {
+
+  public :
+
+    MuonFloatMember pt;
+    MuonFloatMember eta;
+    MuonFloatMember phi;
+    MuonIntMember   charge;
+
+  };
+
+  // Config strings of the muon IDs and track types, with the members
+  // and the branch names they map to. This is the only place where the
+  // strings are listed, selections and branch lists derive from it
+
+  class MuonIdEntry {
+
+  public :
+
+    const char *  name;   // config string
+    MuonIntMember member;
+    const char *  branch; // name of the member
+
+  };
+
+  class TrackTypeEntry {
+
+  public :
+
+    const char * name;        // config string
+    TrackMembers members;
+    const char * branches[4]; // names of members pt, eta, phi, charge
+
+  };
+
+  // Entry of a given muon ID (GLOBAL, SOFT, LOOSE, MEDIUM, TIGHT, HIGHPT)
+  inline const MuonIdEntry & muonIdEntry(const std::string & muonId)
+  {
+    static const MuonIdEntry entries[] = {
+      { "GLOBAL", &muon_pog::Muon::isGlobal, "isGlobal" },
+      { "TIGHT",  &muon_pog::Muon::isTight,  "isTight"  },
+      { "MEDIUM", &muon_pog::Muon::isMedium, "isMedium" },
+      { "LOOSE",  &muon_pog::Muon::isLoose,  "isLoose"  },
+      { "HIGHPT", &muon_pog::Muon::isHighPt, "isHighPt" },
+      { "SOFT",   &muon_pog::Muon::isSoft,   "isSoft"   }
+    };
+
+    for (auto & entry : entries)
+      if (muonId == entry.name)
+	return entry;
+
+    std::cout << "[muonIdEntry]: Invalid muon id : "
+	      << muonId << std::endl;
+    exit(900);
+  }
+
+  // Entry of a given track type (INNER, GLB, TUNEP, PF)
+  inline const TrackTypeEntry & trackTypeEntry(const std::string & trackType)
+  {
+    static const TrackTypeEntry entries[] = {
+      { "PF",
+	{ &muon_pog::Muon::pt,         &muon_pog::Muon::eta,         &muon_pog::Muon::phi,         &muon_pog::Muon::charge },
+	{ "pt",         "eta",         "phi",         "charge" } },
+      { "TUNEP",
+	{ &muon_pog::Muon::pt_tuneP,   &muon_pog::Muon::eta_tuneP,   &muon_pog::Muon::phi_tuneP,   &muon_pog::Muon::charge_tuneP },
+	{ "pt_tuneP",   "eta_tuneP",   "phi_tuneP",   "charge_tuneP" } },
+      { "GLB",
+	{ &muon_pog::Muon::pt_global,  &muon_pog::Muon::eta_global,  &muon_pog::Muon::phi_global,  &muon_pog::Muon::charge_global },
+	{ "pt_global",  "eta_global",  "phi_global",  "charge_global" } },
+      { "INNER",
+	{ &muon_pog::Muon::pt_tracker, &muon_pog::Muon::eta_tracker, &muon_pog::Muon::phi_tracker, &muon_pog::Muon::charge_tracker },
+	{ "pt_tracker", "eta_tracker", "phi_tracker", "charge_tracker" } }
+    };
+
+    for (auto & entry : entries)
+      if (trackType == entry.name)
+	return entry;
+
+    std::cout << "[trackTypeEntry]: Invalid track type: "
+	      << trackType << std::endl;
+    exit(900);
+  }
+
+  // Member holding a given muon ID flag
+  inline MuonIntMember idMember(const std::string & muonId)
+  {
+    return muonIdEntry(muonId).member;
+  }
+
+  // Name of the member holding a given muon ID flag
+  inline std::string idBranchName(const std::string & muonId)
+  {
+    return muonIdEntry(muonId).branch;
+  }
+
+  // Members holding pt, eta, phi and charge for a given track type
+  inline TrackMembers trackMembers(const std::string & trackType)
+  {
+    return trackTypeEntry(trackType).members;
+  }
+
+  // Names of the members holding pt, eta, phi and charge for a given track type
+  inline std::vector<std::string> trackBranchNames(const std::string & trackType)
+  {
+    const TrackTypeEntry & entry = trackTypeEntry(trackType);
+    return std::vector<std::string>(entry.branches, entry.branches + 4);
+  }
+
+}
+#endif
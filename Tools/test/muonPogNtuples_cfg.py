@@ -3,13 +3,16 @@ import FWCore.ParameterSet.Config as cms
 import subprocess
 
 runOnMC = False
+nThreads = 4 # MuonPogTreeProducer is thread safe, other modules can run concurrently
 
 process = cms.Process("NTUPLES")
 
 process.load('Configuration.StandardSequences.Services_cff')
 process.load('FWCore.MessageService.MessageLogger_cfi')
 
-process.options   = cms.untracked.PSet( wantSummary = cms.untracked.bool(True) )
+process.options   = cms.untracked.PSet( wantSummary = cms.untracked.bool(True),
+                                      numberOfThreads = cms.untracked.uint32(nThreads),
+                                      numberOfStreams = cms.untracked.uint32(0) )
 process.MessageLogger.cerr.FwkReport.reportEvery = 1000
 process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(-1))
 
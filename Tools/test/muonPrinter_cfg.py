@@ -32,7 +32,12 @@ process.muonEventDumper = cms.EDAnalyzer("MuonEventDumper",
                              BeamSpotTag      = cms.untracked.InputTag("offlineBeamSpot"),
                              
                              GenTag = cms.untracked.InputTag("none"),
-                             PileUpInfoTag = cms.untracked.InputTag("none")
+                             PileUpInfoTag = cms.untracked.InputTag("none"),
+
+                             EventList = cms.untracked.string(""), # run:lumi:event file or comma separated list, empty for all events
+
+                             DumpFormat = cms.untracked.string("TEXT"), # TEXT, JSON (one line per event), BINARY
+                             OutputFile = cms.untracked.string("")      # empty for std::cout
                              )
 
 process.AOutput = cms.EndPath(process.muonEventDumper)